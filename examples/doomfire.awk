@@ -31,9 +31,6 @@ BEGIN {
                                 struct["pixel_format"])
 
     init_color_palette()
-    SDL_SetPaletteColors(struct["pixel_format"]["palette"],
-                         palette,
-                         0, NUM_COLORS)
 
     init_screen_buffer()
     SDL_FillRect(screen_buffer, NULL, NUM_COLORS - 1)
@@ -64,56 +61,26 @@ BEGIN {
         SDL_Delay(WAIT)
     }
 
+    SDL_Gawk_FreeColorPalette(palette)
     SDL_FreeSurface(screen_buffer)
     SDL_DestroyWindow(window)
     SDL_Quit()
     exit 0
 }
 
-function init_color_palette(    i)
+function init_color_palette(    colors)
 {
-    i = 0
-    palette = SDL_Gawk_AllocColorPalette(COLOR_DEPTH)
+    colors = ""
+    colors = colors "000000 000000 070707 1F0707 2F0F07 470F07 571707 671F07 "
+    colors = colors "771F07 8F2707 9F2F07 AF3F07 BF4707 C74707 DF4F07 DF5707 "
+    colors = colors "DF5707 D75F07 D75F07 D7670F CF6F0F CF770F CF7F0F CF8717 "
+    colors = colors "C78717 C78F17 C7971F BF9F1F BF9F1F BFA727 BFA727 BFAF2F "
+    colors = colors "B7AF2F B7B72F B7B737 CFCF6F DFDF9F EFEFC7 FFFFFF"
 
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x00, 0x00, 0x00, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x00, 0x00, 0x00, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x07, 0x07, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x1F, 0x07, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x2F, 0x0F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x47, 0x0F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x57, 0x17, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x67, 0x1F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x77, 0x1F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x8F, 0x27, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0x9F, 0x2F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xAF, 0x3F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xBF, 0x47, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xC7, 0x47, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xDF, 0x4F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xDF, 0x57, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xDF, 0x57, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xD7, 0x5F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xD7, 0x5F, 0x07, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xD7, 0x67, 0x0F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xCF, 0x6F, 0x0F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xCF, 0x77, 0x0F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xCF, 0x7F, 0x0F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xCF, 0x87, 0x17, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xC7, 0x87, 0x17, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xC7, 0x8F, 0x17, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xC7, 0x97, 0x1F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xBF, 0x9F, 0x1F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xBF, 0x9F, 0x1F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xBF, 0xA7, 0x27, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xBF, 0xA7, 0x27, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xBF, 0xAF, 0x2F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xB7, 0xAF, 0x2F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xB7, 0xB7, 0x2F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xB7, 0xB7, 0x37, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xCF, 0xCF, 0x6F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xDF, 0xDF, 0x9F, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xEF, 0xEF, 0xC7, 0xFF)
-    SDL_Gawk_UpdateColorPalette(palette, i++, 0xFF, 0xFF, 0xFF, 0xFF)
+    palette = SDL_Gawk_AllocColorPalette(COLOR_DEPTH)
+    SDL_Gawk_LoadColorPalette(palette,
+                              colors,
+                              struct["pixel_format"]["palette"])
 }
 
 function init_screen_buffer(    x)
@@ -16,7 +16,7 @@ BEGIN {
     BALL_SIZE    = 20
     BALL_SPEED   = 10
     MAX_POINTS   = 9
-    PIXEL_SIZE   = 10
+    FONT_SCALE   = 5
     WAIT         = 1000 / 60
 
     srand()
@@ -53,14 +53,12 @@ BEGIN {
     ball["vy"]  = BALL_SPEED
 
     score_l["points"] = 0
-    score_l["x"]      = WINDOW_W * 0.25 - PIXEL_SIZE * 1.5
-    score_l["y"]      = PIXEL_SIZE * 2
-    init_pixels(score_l)
+    score_l["x"]      = WINDOW_W * 0.25 - FONT_SCALE * 4
+    score_l["y"]      = FONT_SCALE * 4
 
     score_r["points"] = 0
-    score_r["x"]      = WINDOW_W * 0.75 - PIXEL_SIZE * 1.5
-    score_r["y"]      = PIXEL_SIZE * 2
-    init_pixels(score_r)
+    score_r["x"]      = WINDOW_W * 0.75 - FONT_SCALE * 4
+    score_r["y"]      = FONT_SCALE * 4
 
     event = SDL_Gawk_AllocEvent()
     SDL_Gawk_UpdateRect(paddle_l["ptr"],
@@ -281,59 +279,10 @@ function abs(num)
     return num < 0 ? -num : num
 }
 
-function init_pixels(score,    i)
+function render_score(score)
 {
-    for (i = 1; i <= 15; i++) {
-        score["pixels"][i]["ptr"] = SDL_Gawk_AllocRect()
-        score["pixels"][i]["x"]   = score["x"] + PIXEL_SIZE * ((i - 1) % 3)
-        score["pixels"][i]["y"]   = score["y"] + PIXEL_SIZE * int((i - 1) / 3)
-        SDL_Gawk_UpdateRect(score["pixels"][i]["ptr"],
-                            score["pixels"][i]["x"], score["pixels"][i]["y"],
-                            PIXEL_SIZE, PIXEL_SIZE)
-    }
-}
-
-function render_score(score,    pixels, i)
-{
-    switch (score["points"]) {
-        case 0:
-            split("111101101101111", pixels, "")
-            break
-        case 1:
-            split("001001001001001", pixels, "")
-            break
-        case 2:
-            split("111001111100111", pixels, "")
-            break
-        case 3:
-            split("111001111001111", pixels, "")
-            break
-        case 4:
-            split("101101111001001", pixels, "")
-            break
-        case 5:
-            split("111100111001111", pixels, "")
-            break
-        case 6:
-            split("100100111101111", pixels, "")
-            break
-        case 7:
-            split("111001001001001", pixels, "")
-            break
-        case 8:
-            split("111101111101111", pixels, "")
-            break
-        case 9:
-            split("111101111001001", pixels, "")
-            break
-        default:
-            split("111001011000010", pixels, "")
-            break
-    }
-
-    for (i = 1; i <= 15; i++) {
-        if (pixels[i]) {
-            SDL_RenderFillRect(renderer, score["pixels"][i]["ptr"])
-        }
-    }
+    SDL_Gawk_DrawText(renderer,
+                      score["x"], score["y"],
+                      score["points"] <= 9 ? score["points"] : "?",
+                      FONT_SCALE)
 }
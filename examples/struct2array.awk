@@ -24,6 +24,11 @@ BEGIN {
                                 SDL_TEXTUREACCESS_TARGET,
                                 WINDOW_W, WINDOW_H)
 
+    SDL_SetRenderTarget(renderer, texture)
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255)
+    SDL_RenderClear(renderer)
+    SDL_SetRenderTarget(renderer, NULL)
+
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255)
     SDL_RenderClear(renderer)
 
@@ -6,16 +6,21 @@
 #endif
 
 #include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <gawkapi.h>
 #define _(msgid) msgid
 
+#include "font8x8.h"
 #include "sdl2.h"
 
 #define RETURN_NOK return make_number(-1, result)
@@ -29,6 +34,7 @@ static awk_ext_id_t ext_id;
 static awk_bool_t init_sdl2(void);
 static awk_bool_t (*init_func)(void) = init_sdl2;
 static const char *ext_version = "SDL2 extension: version (untracked)";
+static void forget_renderer(SDL_Renderer *renderer);
 
 awk_bool_t gawk_api_varinit_constant(const gawk_api_t *,
                                      awk_ext_id_t,
@@ -111,6 +117,11 @@ static awk_scalar_t SDL_RENDERER_TARGETTEXTURE_node;
 static awk_scalar_t SDL_TEXTUREACCESS_STATIC_node;
 static awk_scalar_t SDL_TEXTUREACCESS_STREAMING_node;
 static awk_scalar_t SDL_TEXTUREACCESS_TARGET_node;
+static awk_scalar_t SDL_BLENDMODE_NONE_node;
+static awk_scalar_t SDL_BLENDMODE_BLEND_node;
+static awk_scalar_t SDL_BLENDMODE_ADD_node;
+static awk_scalar_t SDL_BLENDMODE_MOD_node;
+static awk_scalar_t SDL_BLENDMODE_MUL_node;
 
 /* Pixel Formats and Conversion Routines */
 static awk_scalar_t SDL_PIXELFORMAT_UNKNOWN_node;
@@ -561,6 +572,11 @@ static const struct varinit varinit[] = {
     ENTRY(SDL_TEXTUREACCESS_STATIC, 1),
     ENTRY(SDL_TEXTUREACCESS_STREAMING, 1),
     ENTRY(SDL_TEXTUREACCESS_TARGET, 1),
+    ENTRY(SDL_BLENDMODE_NONE, 1),
+    ENTRY(SDL_BLENDMODE_BLEND, 1),
+    ENTRY(SDL_BLENDMODE_ADD, 1),
+    ENTRY(SDL_BLENDMODE_MOD, 1),
+    ENTRY(SDL_BLENDMODE_MUL, 1),
     ENTRY(SDL_PIXELFORMAT_UNKNOWN, 1),
     ENTRY(SDL_PIXELFORMAT_INDEX1LSB, 1),
     ENTRY(SDL_PIXELFORMAT_INDEX1MSB, 1),
@@ -948,6 +964,152 @@ load_vars(void)
     }
 }
 
+/* fixed-size objects handed out to awk (rects, events) are carved from
+   slabs and recycled through a free list instead of being malloc'ed one
+   by one */
+
+#define POOL_SLAB_SLOTS 128
+
+enum slot_state { SLOT_FREE, SLOT_USED, SLOT_ARENA };
+
+struct pool_slot {
+    struct pool_slot *next; /* next free slot, or next arena slot */
+    enum slot_state state;
+    double object[];        /* the object, as handed out to awk */
+};
+
+struct pool_slab {
+    struct pool_slab *next;
+    unsigned char *end;
+    unsigned char slots[];
+};
+
+struct object_pool {
+    size_t object_size;
+    size_t slot_size;
+    struct pool_slab *slabs;
+    struct pool_slot *free_slots;
+};
+
+/* pool_init --- set up an empty pool for objects of the given size */
+
+static void
+pool_init(struct object_pool *pool, size_t object_size)
+{
+    size_t align = sizeof(struct pool_slot);
+
+    pool->object_size = object_size;
+    pool->slot_size = (offsetof(struct pool_slot, object) + object_size
+                       + align - 1)
+                      / align * align;
+    pool->slabs = NULL;
+    pool->free_slots = NULL;
+}
+
+/* pool_alloc --- take a zeroed object from the pool, adding a slab when
+                  the free list runs dry */
+
+static void *
+pool_alloc(struct object_pool *pool, enum slot_state state)
+{
+    struct pool_slot *slot;
+
+    if (pool->free_slots == NULL) {
+        struct pool_slab *slab;
+        size_t i;
+
+        slab = gawk_malloc(sizeof(struct pool_slab)
+                           + pool->slot_size * POOL_SLAB_SLOTS);
+        if (slab == NULL)
+            return NULL;
+
+        slab->end = slab->slots + pool->slot_size * POOL_SLAB_SLOTS;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+
+        for (i = POOL_SLAB_SLOTS; i-- > 0;) {
+            slot = (struct pool_slot *)(slab->slots + pool->slot_size * i);
+            slot->state = SLOT_FREE;
+            slot->next = pool->free_slots;
+            pool->free_slots = slot;
+        }
+    }
+
+    slot = pool->free_slots;
+    pool->free_slots = slot->next;
+    slot->next = NULL;
+    slot->state = state;
+    memset(slot->object, 0, pool->object_size);
+    return slot->object;
+}
+
+/* pool_find --- map an object handle back to its live slot, or NULL if
+                 the handle does not belong to the pool */
+
+static struct pool_slot *
+pool_find(struct object_pool *pool, const char *handle)
+{
+    struct pool_slab *slab;
+    uintptr_t object_ptr;
+
+    object_ptr = strtoull(handle, (char **)NULL, 16);
+    for (slab = pool->slabs; slab != NULL; slab = slab->next) {
+        uintptr_t offset;
+        struct pool_slot *slot;
+
+        if (object_ptr < (uintptr_t)slab->slots
+            || object_ptr >= (uintptr_t)slab->end)
+            continue;
+
+        offset = object_ptr - (uintptr_t)slab->slots;
+        if (offset % pool->slot_size
+            != offsetof(struct pool_slot, object))
+            return NULL;
+
+        slot = (struct pool_slot *)(object_ptr
+                                    - offsetof(struct pool_slot, object));
+        return slot->state == SLOT_FREE ? NULL : slot;
+    }
+
+    return NULL;
+}
+
+/* pool_free --- return a slot to the free list */
+
+static void
+pool_free(struct object_pool *pool, struct pool_slot *slot)
+{
+    slot->state = SLOT_FREE;
+    slot->next = pool->free_slots;
+    pool->free_slots = slot;
+}
+
+/* contiguous rectangles handed out by SDL_Gawk_AllocRects(); the awk
+   handle is the address of rects[], which is also a valid SDL_Rect * */
+struct rect_array {
+    struct rect_array *next;
+    int count;
+    SDL_Rect rects[];
+};
+
+static struct rect_array *rect_arrays;
+
+/* find_rect_array --- look up a rect array handle */
+
+static struct rect_array *
+find_rect_array(const char *handle)
+{
+    struct rect_array *array;
+    uintptr_t rects_ptr;
+
+    rects_ptr = strtoull(handle, (char **)NULL, 16);
+    for (array = rect_arrays; array != NULL; array = array->next)
+        if ((uintptr_t)array->rects == rects_ptr)
+            return array;
+
+    return NULL;
+}
+
 /*----- Initialization and Shutdown ----------------------------------------*/
 
 /* int SDL_Init(Uint32 flags); */
@@ -1240,6 +1402,215 @@ do_SDL_UpdateWindowSurface(int nargs,
 
 /*----- 2D Accelerated Rendering -------------------------------------------*/
 
+/* what the extension last set on a renderer, so that repeating the same
+   color, blend mode or target costs no call into SDL */
+enum {
+    STATE_COLOR = 1 << 0,
+    STATE_BLEND = 1 << 1,
+    STATE_TARGET = 1 << 2,
+};
+
+enum primitive_kind {
+    PRIMITIVE_FILL_RECT,
+    PRIMITIVE_DRAW_RECT,
+    PRIMITIVE_LINE,
+};
+
+/* a primitive waiting in a renderer's queue; lines keep their end points
+   in the rect fields */
+struct queued_primitive {
+    SDL_Color color;
+    enum primitive_kind kind;
+    size_t seq; /* queue order, to keep the sort stable */
+    SDL_Rect rect;
+};
+
+struct renderer_state {
+    struct renderer_state *next;
+    SDL_Renderer *renderer;
+    int known; /* STATE_* bits of the fields below that are valid */
+    SDL_Color color;
+    SDL_BlendMode blend_mode;
+    SDL_Texture *target;
+    unsigned long state_calls, state_elided;
+    unsigned long draw_calls, flushes;
+    size_t num_queued, queue_capacity;
+    struct queued_primitive *queue;
+};
+
+static struct renderer_state *renderer_states;
+
+/* get_renderer_state --- find or add the state of a renderer; NULL only
+                          if out of memory, when callers go straight to
+                          SDL */
+
+static struct renderer_state *
+get_renderer_state(SDL_Renderer *renderer)
+{
+    struct renderer_state *state;
+
+    /* most scripts have a single renderer, which stays at the head */
+    for (state = renderer_states; state != NULL; state = state->next)
+        if (state->renderer == renderer)
+            return state;
+
+    state = gawk_calloc(1, sizeof(struct renderer_state));
+    if (state == NULL)
+        return NULL;
+
+    state->renderer = renderer;
+    state->next = renderer_states;
+    renderer_states = state;
+    return state;
+}
+
+/* set_draw_color --- SDL_SetRenderDrawColor() unless already set */
+
+static int
+set_draw_color(SDL_Renderer *renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    struct renderer_state *state = get_renderer_state(renderer);
+    int ret;
+
+    if (state != NULL && (state->known & STATE_COLOR)
+        && state->color.r == r && state->color.g == g
+        && state->color.b == b && state->color.a == a) {
+        state->state_elided++;
+        return 0;
+    }
+
+    ret = SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    if (state != NULL) {
+        state->state_calls++;
+        state->known &= ~STATE_COLOR;
+        if (ret == 0) {
+            state->color.r = r;
+            state->color.g = g;
+            state->color.b = b;
+            state->color.a = a;
+            state->known |= STATE_COLOR;
+        }
+    }
+
+    return ret;
+}
+
+/* get_draw_color --- SDL_GetRenderDrawColor(), answered from the cache
+                      when possible */
+
+static int
+get_draw_color(SDL_Renderer *renderer,
+               Uint8 *r,
+               Uint8 *g,
+               Uint8 *b,
+               Uint8 *a)
+{
+    struct renderer_state *state = get_renderer_state(renderer);
+    int ret;
+
+    if (state != NULL && (state->known & STATE_COLOR)) {
+        *r = state->color.r;
+        *g = state->color.g;
+        *b = state->color.b;
+        *a = state->color.a;
+        return 0;
+    }
+
+    ret = SDL_GetRenderDrawColor(renderer, r, g, b, a);
+    if (state != NULL && ret == 0) {
+        state->color.r = *r;
+        state->color.g = *g;
+        state->color.b = *b;
+        state->color.a = *a;
+        state->known |= STATE_COLOR;
+    }
+
+    return ret;
+}
+
+/* set_draw_blend_mode --- SDL_SetRenderDrawBlendMode() unless already
+                           set */
+
+static int
+set_draw_blend_mode(SDL_Renderer *renderer, SDL_BlendMode blend_mode)
+{
+    struct renderer_state *state = get_renderer_state(renderer);
+    int ret;
+
+    if (state != NULL && (state->known & STATE_BLEND)
+        && state->blend_mode == blend_mode) {
+        state->state_elided++;
+        return 0;
+    }
+
+    ret = SDL_SetRenderDrawBlendMode(renderer, blend_mode);
+    if (state != NULL) {
+        state->state_calls++;
+        state->known &= ~STATE_BLEND;
+        if (ret == 0) {
+            state->blend_mode = blend_mode;
+            state->known |= STATE_BLEND;
+        }
+    }
+
+    return ret;
+}
+
+/* set_render_target --- SDL_SetRenderTarget() unless already set */
+
+static int
+set_render_target(SDL_Renderer *renderer, SDL_Texture *texture)
+{
+    struct renderer_state *state = get_renderer_state(renderer);
+    int ret;
+
+    if (state != NULL && (state->known & STATE_TARGET)
+        && state->target == texture) {
+        state->state_elided++;
+        return 0;
+    }
+
+    ret = SDL_SetRenderTarget(renderer, texture);
+    if (state != NULL) {
+        state->state_calls++;
+        state->known &= ~STATE_TARGET;
+        if (ret == 0) {
+            state->target = texture;
+            state->known |= STATE_TARGET;
+        }
+    }
+
+    return ret;
+}
+
+/* get_render_target --- SDL_GetRenderTarget(), answered from the cache
+                         when possible */
+
+static SDL_Texture *
+get_render_target(SDL_Renderer *renderer)
+{
+    struct renderer_state *state = get_renderer_state(renderer);
+
+    if (state != NULL && (state->known & STATE_TARGET))
+        return state->target;
+
+    return SDL_GetRenderTarget(renderer);
+}
+
+/* forget_texture --- SDL resets the target of a renderer whose target
+                      texture is destroyed; follow it */
+
+static void
+forget_texture(SDL_Texture *texture)
+{
+    struct renderer_state *state;
+
+    for (state = renderer_states; state != NULL; state = state->next)
+        if ((state->known & STATE_TARGET) && state->target == texture)
+            state->target = NULL;
+}
+
+
 /* SDL_Renderer *SDL_CreateRenderer(SDL_Window *window,
                                     int index,
                                     Uint32 flags); */
@@ -1305,6 +1676,7 @@ do_SDL_DestroyRenderer(int nargs,
                             (char **)NULL,
                             16);
 
+    forget_renderer((SDL_Renderer *)renderer_ptr);
     SDL_DestroyRenderer((SDL_Renderer *)renderer_ptr);
     RETURN_OK;
 }
@@ -1496,6 +1868,96 @@ do_SDL_RenderFillRect(int nargs,
     return make_number(ret, result);
 }
 
+/* int SDL_RenderDrawRects(SDL_Renderer *renderer,
+                           const SDL_Rect *rects, int count); */
+/* do_SDL_RenderDrawRects --- provide a SDL_RenderDrawRects()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_RenderDrawRects(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t rects_ptr_param;
+    awk_value_t count_param;
+    uintptr_t renderer_ptr;
+    struct rect_array *array;
+    int count;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_STRING, &rects_ptr_param)
+        || ! get_argument(2, AWK_NUMBER, &count_param)) {
+        warning(ext_id, _("SDL_RenderDrawRects: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
+    array = find_rect_array(rects_ptr_param.str_value.str);
+    count = count_param.num_value;
+
+    if (array == NULL || count < 0 || count > array->count) {
+        warning(ext_id, _("SDL_RenderDrawRects: invalid rectangles"));
+        RETURN_NOK;
+    }
+
+    ret = SDL_RenderDrawRects((SDL_Renderer *)renderer_ptr,
+                              array->rects,
+                              count);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_RenderDrawRects failed"));
+
+    return make_number(ret, result);
+}
+
+/* int SDL_RenderFillRects(SDL_Renderer *renderer,
+                           const SDL_Rect *rects, int count); */
+/* do_SDL_RenderFillRects --- provide a SDL_RenderFillRects()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_RenderFillRects(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t rects_ptr_param;
+    awk_value_t count_param;
+    uintptr_t renderer_ptr;
+    struct rect_array *array;
+    int count;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_STRING, &rects_ptr_param)
+        || ! get_argument(2, AWK_NUMBER, &count_param)) {
+        warning(ext_id, _("SDL_RenderFillRects: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
+    array = find_rect_array(rects_ptr_param.str_value.str);
+    count = count_param.num_value;
+
+    if (array == NULL || count < 0 || count > array->count) {
+        warning(ext_id, _("SDL_RenderFillRects: invalid rectangles"));
+        RETURN_NOK;
+    }
+
+    ret = SDL_RenderFillRects((SDL_Renderer *)renderer_ptr,
+                              array->rects,
+                              count);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_RenderFillRects failed"));
+
+    return make_number(ret, result);
+}
+
 /* void SDL_RenderPresent(SDL_Renderer *renderer); */
 /* do_SDL_RenderPresent --- provide a SDL_RenderPresent() function for gawk */
 
@@ -1553,134 +2015,275 @@ do_SDL_SetRenderDrawColor(int nargs,
     b = b_param.num_value;
     a = a_param.num_value;
 
-    ret = SDL_SetRenderDrawColor((SDL_Renderer *)renderer_ptr, r, g, b, a);
+    ret = set_draw_color((SDL_Renderer *)renderer_ptr, r, g, b, a);
     if (ret < 0)
         update_ERRNO_string(_("SDL_SetRenderDrawColor failed"));
 
     return make_number(ret, result);
 }
 
-/* SDL_Texture *SDL_CreateTexture(SDL_Renderer *renderer,
-                                  Uint32 format,
-                                  int access,
-                                  int w, int h); */
-/* do_SDL_CreateTexture --- provide a SDL_CreateTexture() function for gawk */
+/* int SDL_SetRenderDrawBlendMode(SDL_Renderer *renderer,
+                                  SDL_BlendMode blendMode); */
+/* do_SDL_SetRenderDrawBlendMode --- provide a SDL_SetRenderDrawBlendMode()
+                                     function for gawk */
 
 static awk_value_t *
-do_SDL_CreateTexture(int nargs,
-                     awk_value_t *result,
-                     struct awk_ext_func *finfo)
+do_SDL_SetRenderDrawBlendMode(int nargs,
+                              awk_value_t *result,
+                              struct awk_ext_func *finfo)
 {
-    SDL_Texture *texture;
     awk_value_t renderer_ptr_param;
-    awk_value_t format_param;
-    awk_value_t access_param;
-    awk_value_t w_param, h_param;
+    awk_value_t blend_mode_param;
     uintptr_t renderer_ptr;
-    uint32_t format;
-    int access;
-    int w, h;
+    SDL_BlendMode blend_mode;
+    int ret;
 
     if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
-        || ! get_argument(1, AWK_NUMBER, &format_param)
-        || ! get_argument(2, AWK_NUMBER, &access_param)
-        || ! get_argument(3, AWK_NUMBER, &w_param)
-        || ! get_argument(4, AWK_NUMBER, &h_param)) {
-        warning(ext_id, _("SDL_CreateTexture: bad parameter(s)"));
+        || ! get_argument(1, AWK_NUMBER, &blend_mode_param)) {
+        warning(ext_id, _("SDL_SetRenderDrawBlendMode: bad parameter(s)"));
         RETURN_NOK;
     }
 
     renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
                             (char **)NULL,
                             16);
-    format = format_param.num_value;
-    access = access_param.num_value;
-    w = w_param.num_value;
-    h = h_param.num_value;
-
-    texture = SDL_CreateTexture((SDL_Renderer *)renderer_ptr,
-                                format,
-                                access,
-                                w, h);
+    blend_mode = (SDL_BlendMode)blend_mode_param.num_value;
 
-    if (texture) {
-        char texture_addr[20];
-        // NOLINTNEXTLINE
-        snprintf(texture_addr, sizeof(texture_addr), "%p", texture);
-        return make_string_malloc(texture_addr, strlen(texture_addr), result);
-    }
+    ret = set_draw_blend_mode((SDL_Renderer *)renderer_ptr, blend_mode);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_SetRenderDrawBlendMode failed"));
 
-    update_ERRNO_string(_("SDL_CreateTexture failed"));
-    return make_null_string(result);
+    return make_number(ret, result);
 }
 
-/* SDL_Texture *SDL_CreateTextureFromSurface(SDL_Renderer *renderer,
-                                             SDL_Surface *surface); */
-/* do_SDL_CreateTextureFromSurface --- provide a
-                                       SDL_CreateTextureFromSurface()
-                                       function for gawk */
+/* int SDL_GetRenderDrawBlendMode(SDL_Renderer *renderer,
+                                  SDL_BlendMode *blendMode); */
+/* do_SDL_GetRenderDrawBlendMode --- provide a SDL_GetRenderDrawBlendMode()
+                                     function for gawk */
 
 static awk_value_t *
-do_SDL_CreateTextureFromSurface(int nargs,
-                                awk_value_t *result,
-                                struct awk_ext_func *finfo)
+do_SDL_GetRenderDrawBlendMode(int nargs,
+                              awk_value_t *result,
+                              struct awk_ext_func *finfo)
 {
-    SDL_Texture *texture;
     awk_value_t renderer_ptr_param;
-    awk_value_t surface_ptr_param;
     uintptr_t renderer_ptr;
-    uintptr_t surface_ptr;
+    SDL_BlendMode blend_mode;
+    int ret;
 
-    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
-        || ! get_argument(1, AWK_STRING, &surface_ptr_param)) {
-        warning(ext_id, _("SDL_CreateTextureFromSurface: bad parameter(s)"));
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)) {
+        warning(ext_id, _("SDL_GetRenderDrawBlendMode: bad parameter(s)"));
         RETURN_NOK;
     }
 
     renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
                             (char **)NULL,
                             16);
-    surface_ptr = strtoull(surface_ptr_param.str_value.str,
-                           (char **)NULL,
-                           16);
-
-    texture = SDL_CreateTextureFromSurface((SDL_Renderer *)renderer_ptr,
-                                           (SDL_Surface *)surface_ptr);
 
-    if (texture) {
-        char texture_addr[20];
-        // NOLINTNEXTLINE
-        snprintf(texture_addr, sizeof(texture_addr), "%p", texture);
-        return make_string_malloc(texture_addr, strlen(texture_addr), result);
+    /* the mode itself is returned, or -1 on error */
+    ret = SDL_GetRenderDrawBlendMode((SDL_Renderer *)renderer_ptr,
+                                     &blend_mode);
+    if (ret < 0) {
+        update_ERRNO_string(_("SDL_GetRenderDrawBlendMode failed"));
+        return make_number(ret, result);
     }
 
-    update_ERRNO_string(_("SDL_CreateTextureFromSurface failed"));
-    return make_null_string(result);
+    return make_number(blend_mode, result);
 }
 
-/* void SDL_DestroyTexture(SDL_Texture *texture); */
-/* do_SDL_DestroyTexture --- provide a SDL_DestroyTexture()
-                             function for gawk */
+/* int SDL_SetRenderTarget(SDL_Renderer *renderer, SDL_Texture *texture); */
+/* do_SDL_SetRenderTarget --- provide a SDL_SetRenderTarget() function for
+                              gawk */
 
 static awk_value_t *
-do_SDL_DestroyTexture(int nargs,
-                      awk_value_t *result,
-                      struct awk_ext_func *finfo)
+do_SDL_SetRenderTarget(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
 {
+    awk_value_t renderer_ptr_param;
     awk_value_t texture_ptr_param;
+    uintptr_t renderer_ptr;
     uintptr_t texture_ptr;
+    int ret;
 
-    if (! get_argument(0, AWK_STRING, &texture_ptr_param)) {
-        warning(ext_id, _("SDL_DestroyTexture: bad parameter(s)"));
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_STRING, &texture_ptr_param)) {
+        warning(ext_id, _("SDL_SetRenderTarget: bad parameter(s)"));
         RETURN_NOK;
     }
 
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
     texture_ptr = strtoull(texture_ptr_param.str_value.str,
                            (char **)NULL,
                            16);
 
-    SDL_DestroyTexture((SDL_Texture *)texture_ptr);
-    RETURN_OK;
+    ret = set_render_target((SDL_Renderer *)renderer_ptr,
+                            (SDL_Texture *)texture_ptr);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_SetRenderTarget failed"));
+
+    return make_number(ret, result);
+}
+
+/* SDL_Texture *SDL_GetRenderTarget(SDL_Renderer *renderer); */
+/* do_SDL_GetRenderTarget --- provide a SDL_GetRenderTarget() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_GetRenderTarget(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    SDL_Texture *texture;
+    awk_value_t renderer_ptr_param;
+    uintptr_t renderer_ptr;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)) {
+        warning(ext_id, _("SDL_GetRenderTarget: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
+
+    texture = get_render_target((SDL_Renderer *)renderer_ptr);
+
+    /* NULL is the default target, not an error */
+    if (texture) {
+        char texture_addr[20];
+        // NOLINTNEXTLINE
+        snprintf(texture_addr, sizeof(texture_addr), "%p", texture);
+        return make_string_malloc(texture_addr, strlen(texture_addr), result);
+    }
+
+    return make_null_string(result);
+}
+
+/* SDL_Texture *SDL_CreateTexture(SDL_Renderer *renderer,
+                                  Uint32 format,
+                                  int access,
+                                  int w, int h); */
+/* do_SDL_CreateTexture --- provide a SDL_CreateTexture() function for gawk */
+
+static awk_value_t *
+do_SDL_CreateTexture(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
+{
+    SDL_Texture *texture;
+    awk_value_t renderer_ptr_param;
+    awk_value_t format_param;
+    awk_value_t access_param;
+    awk_value_t w_param, h_param;
+    uintptr_t renderer_ptr;
+    uint32_t format;
+    int access;
+    int w, h;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &format_param)
+        || ! get_argument(2, AWK_NUMBER, &access_param)
+        || ! get_argument(3, AWK_NUMBER, &w_param)
+        || ! get_argument(4, AWK_NUMBER, &h_param)) {
+        warning(ext_id, _("SDL_CreateTexture: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
+    format = format_param.num_value;
+    access = access_param.num_value;
+    w = w_param.num_value;
+    h = h_param.num_value;
+
+    texture = SDL_CreateTexture((SDL_Renderer *)renderer_ptr,
+                                format,
+                                access,
+                                w, h);
+
+    if (texture) {
+        char texture_addr[20];
+        // NOLINTNEXTLINE
+        snprintf(texture_addr, sizeof(texture_addr), "%p", texture);
+        return make_string_malloc(texture_addr, strlen(texture_addr), result);
+    }
+
+    update_ERRNO_string(_("SDL_CreateTexture failed"));
+    return make_null_string(result);
+}
+
+/* SDL_Texture *SDL_CreateTextureFromSurface(SDL_Renderer *renderer,
+                                             SDL_Surface *surface); */
+/* do_SDL_CreateTextureFromSurface --- provide a
+                                       SDL_CreateTextureFromSurface()
+                                       function for gawk */
+
+static awk_value_t *
+do_SDL_CreateTextureFromSurface(int nargs,
+                                awk_value_t *result,
+                                struct awk_ext_func *finfo)
+{
+    SDL_Texture *texture;
+    awk_value_t renderer_ptr_param;
+    awk_value_t surface_ptr_param;
+    uintptr_t renderer_ptr;
+    uintptr_t surface_ptr;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_STRING, &surface_ptr_param)) {
+        warning(ext_id, _("SDL_CreateTextureFromSurface: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
+    surface_ptr = strtoull(surface_ptr_param.str_value.str,
+                           (char **)NULL,
+                           16);
+
+    texture = SDL_CreateTextureFromSurface((SDL_Renderer *)renderer_ptr,
+                                           (SDL_Surface *)surface_ptr);
+
+    if (texture) {
+        char texture_addr[20];
+        // NOLINTNEXTLINE
+        snprintf(texture_addr, sizeof(texture_addr), "%p", texture);
+        return make_string_malloc(texture_addr, strlen(texture_addr), result);
+    }
+
+    update_ERRNO_string(_("SDL_CreateTextureFromSurface failed"));
+    return make_null_string(result);
+}
+
+/* void SDL_DestroyTexture(SDL_Texture *texture); */
+/* do_SDL_DestroyTexture --- provide a SDL_DestroyTexture()
+                             function for gawk */
+
+static awk_value_t *
+do_SDL_DestroyTexture(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t texture_ptr_param;
+    uintptr_t texture_ptr;
+
+    if (! get_argument(0, AWK_STRING, &texture_ptr_param)) {
+        warning(ext_id, _("SDL_DestroyTexture: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    texture_ptr = strtoull(texture_ptr_param.str_value.str,
+                           (char **)NULL,
+                           16);
+
+    forget_texture((SDL_Texture *)texture_ptr);
+    SDL_DestroyTexture((SDL_Texture *)texture_ptr);
+    RETURN_OK;
 }
 
 /* int SDL_UpdateTexture(SDL_Texture *texture,
@@ -1731,6 +2334,75 @@ do_SDL_UpdateTexture(int nargs,
 
 /*----- Pixel Formats and Conversion Routines ------------------------------*/
 
+#define MAX_PALETTE_BPP 8
+
+/* heap-backed color palette handed out by SDL_Gawk_AllocColorPalette();
+   the awk handle is the address of colors[], so it can be passed to
+   SDL_SetPaletteColors() as is */
+struct color_palette {
+    struct color_palette *next; /* next live palette, or next free one */
+    int bpp;
+    int ncolors;
+    SDL_Color colors[];
+};
+
+static struct color_palette *color_palettes;
+static struct color_palette *free_color_palettes[MAX_PALETTE_BPP + 1];
+
+/* find_color_palette --- look up a color palette handle */
+
+static struct color_palette *
+find_color_palette(const char *handle)
+{
+    struct color_palette *palette;
+    uintptr_t colors_ptr;
+
+    colors_ptr = strtoull(handle, (char **)NULL, 16);
+    for (palette = color_palettes; palette != NULL; palette = palette->next)
+        if ((uintptr_t)palette->colors == colors_ptr)
+            return palette;
+
+    return NULL;
+}
+
+/* parse_hex_color --- parse a "RRGGBB" or "RRGGBBAA" token, with an
+                       optional leading '#' */
+
+static awk_bool_t
+parse_hex_color(const char *str, size_t len, SDL_Color *color)
+{
+    unsigned long rgba = 0;
+    size_t i;
+
+    if (len > 0 && str[0] == '#') {
+        str++;
+        len--;
+    }
+    if (len != 6 && len != 8)
+        return awk_false;
+
+    for (i = 0; i < len; i++) {
+        int c = str[i];
+
+        if (c >= '0' && c <= '9')
+            rgba = (rgba << 4) | (c - '0');
+        else if (c >= 'a' && c <= 'f')
+            rgba = (rgba << 4) | (c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            rgba = (rgba << 4) | (c - 'A' + 10);
+        else
+            return awk_false;
+    }
+    if (len == 6)
+        rgba = (rgba << 8) | 0xFF;
+
+    color->r = (rgba >> 24) & 0xFF;
+    color->g = (rgba >> 16) & 0xFF;
+    color->b = (rgba >> 8) & 0xFF;
+    color->a = rgba & 0xFF;
+    return awk_true;
+}
+
 /* SDL_Color *SDL_Gawk_AllocColorPalette(int bpp); */
 // /* It doesn't exist in SDL2 */
 /* do_SDL_Gawk_AllocColorPalette --- provide a SDL_Gawk_AllocColorPalette()
@@ -1742,9 +2414,10 @@ do_SDL_Gawk_AllocColorPalette(int nargs,
                               struct awk_ext_func *finfo)
 {
     awk_value_t bpp_param;
+    struct color_palette *palette;
     int bpp;
     char colors_addr[20];
-    size_t i;
+    int i;
 
     if (! get_argument(0, AWK_NUMBER, &bpp_param)) {
         warning(ext_id, _("SDL_Gawk_AllocColorPalette: bad parameter(s)"));
@@ -1753,26 +2426,71 @@ do_SDL_Gawk_AllocColorPalette(int nargs,
 
     bpp = bpp_param.num_value;
 
-    if (bpp < 1 || bpp > 31) {
+    if (bpp < 1 || bpp > MAX_PALETTE_BPP) {
         warning(ext_id,
                 _("SDL_Gawk_AllocColorPalette: invalid color depth %d"),
                 bpp);
         RETURN_NOK;
     }
 
-    SDL_Color colors[1 << bpp];
-    for (i = 0; i < 1 << bpp; i++) {
-        colors[i].r = 255;
-        colors[i].g = 255;
-        colors[i].b = 255;
-        colors[i].a = 255;
+    if ((palette = free_color_palettes[bpp]) != NULL) {
+        free_color_palettes[bpp] = palette->next;
+    } else {
+        palette = gawk_malloc(sizeof(struct color_palette)
+                              + sizeof(SDL_Color) * (1 << bpp));
+        if (palette == NULL) {
+            update_ERRNO_string(_("SDL_Gawk_AllocColorPalette failed"));
+            return make_null_string(result);
+        }
+        palette->bpp = bpp;
+        palette->ncolors = 1 << bpp;
+    }
+
+    for (i = 0; i < palette->ncolors; i++) {
+        palette->colors[i].r = 255;
+        palette->colors[i].g = 255;
+        palette->colors[i].b = 255;
+        palette->colors[i].a = 255;
     }
+    palette->next = color_palettes;
+    color_palettes = palette;
 
     // NOLINTNEXTLINE
-    snprintf(colors_addr, sizeof(colors_addr), "%p", colors);
+    snprintf(colors_addr, sizeof(colors_addr), "%p", palette->colors);
     return make_string_malloc(colors_addr, strlen(colors_addr), result);
 }
 
+/* void SDL_Gawk_FreeColorPalette(SDL_Color *colors); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_FreeColorPalette --- provide a SDL_Gawk_FreeColorPalette()
+                                    function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_FreeColorPalette(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    awk_value_t colors_ptr_param;
+    struct color_palette *palette;
+    struct color_palette **prev;
+
+    if (! get_argument(0, AWK_STRING, &colors_ptr_param)
+        || (palette = find_color_palette(colors_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_FreeColorPalette: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &color_palettes; *prev != palette; prev = &(*prev)->next)
+        ;
+    *prev = palette->next;
+
+    /* keep it for the next palette of the same depth */
+    palette->next = free_color_palettes[palette->bpp];
+    free_color_palettes[palette->bpp] = palette;
+    RETURN_OK;
+}
+
 /* void SDL_Gawk_UpdateColorPalette(SDL_Color *colors,
                                     int index,
                                     Uint8 r, Uint8 g, Uint8 b, Uint8 a); */
@@ -1788,10 +2506,9 @@ do_SDL_Gawk_UpdateColorPalette(int nargs,
     awk_value_t colors_ptr_param;
     awk_value_t index_param;
     awk_value_t r_param, g_param, b_param, a_param;
-    uintptr_t colors_ptr;
+    struct color_palette *palette;
     int index;
     uint8_t r, g, b, a;
-    SDL_Color *colors;
 
     if (! get_argument(0, AWK_STRING, &colors_ptr_param)
         || ! get_argument(1, AWK_NUMBER, &index_param)
@@ -1803,27 +2520,151 @@ do_SDL_Gawk_UpdateColorPalette(int nargs,
         RETURN_NOK;
     }
 
-    colors_ptr = strtoull(colors_ptr_param.str_value.str, (char **)NULL, 16);
+    palette = find_color_palette(colors_ptr_param.str_value.str);
     index = index_param.num_value;
     r = r_param.num_value;
     g = g_param.num_value;
     b = b_param.num_value;
     a = a_param.num_value;
 
-    if (! colors_ptr) {
+    if (palette == NULL) {
         warning(ext_id, _("SDL_Gawk_UpdateColorPalette: invalid colors"));
         RETURN_NOK;
     }
+    if (index < 0 || index >= palette->ncolors) {
+        warning(ext_id,
+                _("SDL_Gawk_UpdateColorPalette: invalid index %d"),
+                index);
+        RETURN_NOK;
+    }
 
-    colors = (SDL_Color *)colors_ptr;
-
-    colors[index].r = r;
-    colors[index].g = g;
-    colors[index].b = b;
-    colors[index].a = a;
+    palette->colors[index].r = r;
+    palette->colors[index].g = g;
+    palette->colors[index].b = b;
+    palette->colors[index].a = a;
     RETURN_OK;
 }
 
+/* int SDL_Gawk_LoadColorPalette(SDL_Color *colors,
+                                 awk_array_t *source,
+                                 SDL_Palette *palette); */
+/* int SDL_Gawk_LoadColorPalette(SDL_Color *colors,
+                                 const char *source,
+                                 SDL_Palette *palette); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_LoadColorPalette --- provide a SDL_Gawk_LoadColorPalette()
+                                    function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_LoadColorPalette(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    awk_value_t colors_ptr_param;
+    awk_value_t source_param;
+    awk_value_t palette_ptr_param;
+    struct color_palette *palette;
+    int ncolors = 0;
+
+    if (! get_argument(0, AWK_STRING, &colors_ptr_param)
+        || ! get_argument(1, AWK_UNDEFINED, &source_param)
+        || (palette = find_color_palette(colors_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_LoadColorPalette: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (source_param.val_type == AWK_ARRAY) {
+        /* elements indexed by color index from 0, either hex strings or
+           numbers of the form 0xRRGGBB */
+        for (; ncolors < palette->ncolors; ncolors++) {
+            awk_value_t index, value;
+            SDL_Color *color = &palette->colors[ncolors];
+
+            if (! get_array_element(source_param.array_cookie,
+                                    make_number(ncolors, &index),
+                                    AWK_UNDEFINED,
+                                    &value))
+                break;
+
+            if (value.val_type == AWK_NUMBER) {
+                uint32_t rgb = value.num_value;
+
+                color->r = (rgb >> 16) & 0xFF;
+                color->g = (rgb >> 8) & 0xFF;
+                color->b = rgb & 0xFF;
+                color->a = 255;
+            } else if ((value.val_type != AWK_STRING
+                        && value.val_type != AWK_STRNUM)
+                       || ! parse_hex_color(value.str_value.str,
+                                            value.str_value.len,
+                                            color)) {
+                warning(ext_id,
+                        _("SDL_Gawk_LoadColorPalette: invalid color at %d"),
+                        ncolors);
+                RETURN_NOK;
+            }
+        }
+    } else if (source_param.val_type == AWK_STRING
+               || source_param.val_type == AWK_STRNUM) {
+        /* tokens separated by blanks or commas */
+        const char *str = source_param.str_value.str;
+        const char *end = str + source_param.str_value.len;
+
+        for (;;) {
+            const char *token;
+
+            while (str < end
+                   && (*str == ' ' || *str == '\t' || *str == '\n'
+                       || *str == ','))
+                str++;
+            if (str == end)
+                break;
+
+            token = str;
+            while (str < end && *str != ' ' && *str != '\t' && *str != '\n'
+                   && *str != ',')
+                str++;
+
+            if (ncolors == palette->ncolors
+                || ! parse_hex_color(token,
+                                     str - token,
+                                     &palette->colors[ncolors])) {
+                warning(ext_id,
+                        _("SDL_Gawk_LoadColorPalette: invalid color at %d"),
+                        ncolors);
+                RETURN_NOK;
+            }
+            ncolors++;
+        }
+    } else {
+        warning(ext_id, _("SDL_Gawk_LoadColorPalette: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 2 && ncolors > 0) {
+        uintptr_t palette_ptr;
+
+        if (! get_argument(2, AWK_STRING, &palette_ptr_param)) {
+            warning(ext_id, _("SDL_Gawk_LoadColorPalette: bad parameter(s)"));
+            RETURN_NOK;
+        }
+
+        palette_ptr = strtoull(palette_ptr_param.str_value.str,
+                               (char **)NULL,
+                               16);
+        if (SDL_SetPaletteColors((SDL_Palette *)palette_ptr,
+                                 palette->colors,
+                                 0, ncolors)
+            < 0) {
+            update_ERRNO_string(_("SDL_Gawk_LoadColorPalette failed"));
+            RETURN_NOK;
+        }
+    }
+
+    return make_number(ncolors, result);
+}
+
 /* SDL_Palette *SDL_AllocPalette(int ncolors); */
 /* do_SDL_AllocPalette --- provide a SDL_AllocPalette() function for gawk */
 
@@ -2206,6 +3047,9 @@ do_SDL_MapRGBA(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 
 /*----- Rectangle Functions ------------------------------------------------*/
 
+static struct object_pool rect_pool;
+static struct pool_slot *arena_rects; /* rects to drop on ArenaReset() */
+
 /* SDL_Rect *SDL_Gawk_AllocRect(void); */
 // /* It doesn't exist in SDL2 */
 /* do_SDL_Gawk_AllocRect --- provide a SDL_Gawk_AllocRect()
@@ -2218,7 +3062,7 @@ do_SDL_Gawk_AllocRect(int nargs,
 {
     SDL_Rect *rect;
 
-    rect = gawk_malloc(sizeof(SDL_Rect));
+    rect = pool_alloc(&rect_pool, SLOT_USED);
 
     if (rect) {
         char rect_addr[20];
@@ -2231,45 +3075,309 @@ do_SDL_Gawk_AllocRect(int nargs,
     return make_null_string(result);
 }
 
-/* void SDL_Gawk_UpdateRect(SDL_Rect *rect, int x, int y, int w, int h); */
+/* void SDL_Gawk_FreeRect(SDL_Rect *rect); */
 // /* It doesn't exist in SDL2 */
-/* do_SDL_Gawk_UpdateRect --- provide a SDL_Gawk_UpdateRect()
-                              function for gawk */
+/* do_SDL_Gawk_FreeRect --- provide a SDL_Gawk_FreeRect()
+                            function for gawk */
 
 static awk_value_t *
-do_SDL_Gawk_UpdateRect(int nargs,
-                       awk_value_t *result,
-                       struct awk_ext_func *finfo)
+do_SDL_Gawk_FreeRect(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
 {
     awk_value_t rect_ptr_param;
-    awk_value_t x_param, y_param;
-    awk_value_t w_param, h_param;
-    uintptr_t rect_ptr;
-    int x, y;
-    int w, h;
-    SDL_Rect *rect;
+    struct pool_slot *slot;
 
-    if (! get_argument(0, AWK_STRING, &rect_ptr_param)
-        || ! get_argument(1, AWK_NUMBER, &x_param)
-        || ! get_argument(2, AWK_NUMBER, &y_param)
-        || ! get_argument(3, AWK_NUMBER, &w_param)
-        || ! get_argument(4, AWK_NUMBER, &h_param)) {
-        warning(ext_id, _("SDL_Gawk_UpdateRect: bad parameter(s)"));
+    if (! get_argument(0, AWK_STRING, &rect_ptr_param)) {
+        warning(ext_id, _("SDL_Gawk_FreeRect: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    rect_ptr = strtoull(rect_ptr_param.str_value.str, (char **)NULL, 16);
-    x = x_param.num_value;
-    y = y_param.num_value;
-    w = w_param.num_value;
-    h = h_param.num_value;
+    slot = pool_find(&rect_pool, rect_ptr_param.str_value.str);
 
-    if (! rect_ptr) {
-        warning(ext_id, _("SDL_Gawk_UpdateRect: invalid rectangle"));
+    /* arena rects are only reclaimed by SDL_Gawk_ArenaReset() */
+    if (slot == NULL || slot->state != SLOT_USED) {
+        warning(ext_id, _("SDL_Gawk_FreeRect: invalid rectangle"));
         RETURN_NOK;
     }
 
-    rect = (SDL_Rect *)rect_ptr;
+    pool_free(&rect_pool, slot);
+    RETURN_OK;
+}
+
+/* SDL_Rect *SDL_Gawk_ArenaAllocRect(void); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ArenaAllocRect --- provide a SDL_Gawk_ArenaAllocRect()
+                                  function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ArenaAllocRect(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    SDL_Rect *rect;
+
+    rect = pool_alloc(&rect_pool, SLOT_ARENA);
+
+    if (rect) {
+        struct pool_slot *slot;
+        char rect_addr[20];
+
+        slot = (struct pool_slot *)((char *)rect
+                                    - offsetof(struct pool_slot, object));
+        slot->next = arena_rects;
+        arena_rects = slot;
+
+        // NOLINTNEXTLINE
+        snprintf(rect_addr, sizeof(rect_addr), "%p", rect);
+        return make_string_malloc(rect_addr, strlen(rect_addr), result);
+    }
+
+    update_ERRNO_string(_("SDL_Gawk_ArenaAllocRect failed"));
+    return make_null_string(result);
+}
+
+/* int SDL_Gawk_ArenaReset(void); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ArenaReset --- provide a SDL_Gawk_ArenaReset()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ArenaReset(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    int count = 0;
+
+    while (arena_rects != NULL) {
+        struct pool_slot *slot = arena_rects;
+
+        arena_rects = slot->next;
+        pool_free(&rect_pool, slot);
+        count++;
+    }
+
+    return make_number(count, result);
+}
+
+/* SDL_Rect *SDL_Gawk_AllocRects(int count); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_AllocRects --- provide a SDL_Gawk_AllocRects()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_AllocRects(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t count_param;
+    struct rect_array *array;
+    int count;
+    char rects_addr[20];
+
+    if (! get_argument(0, AWK_NUMBER, &count_param)) {
+        warning(ext_id, _("SDL_Gawk_AllocRects: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    count = count_param.num_value;
+
+    if (count < 1) {
+        warning(ext_id, _("SDL_Gawk_AllocRects: invalid count %d"), count);
+        RETURN_NOK;
+    }
+
+    array = gawk_calloc(1, sizeof(struct rect_array)
+                               + sizeof(SDL_Rect) * count);
+    if (array == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_AllocRects failed"));
+        return make_null_string(result);
+    }
+
+    array->count = count;
+    array->next = rect_arrays;
+    rect_arrays = array;
+
+    // NOLINTNEXTLINE
+    snprintf(rects_addr, sizeof(rects_addr), "%p", array->rects);
+    return make_string_malloc(rects_addr, strlen(rects_addr), result);
+}
+
+/* int SDL_Gawk_SetRects(SDL_Rect *rects, awk_array_t *values, int first); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_SetRects --- provide a SDL_Gawk_SetRects()
+                            function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_SetRects(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
+{
+    awk_value_t rects_ptr_param;
+    awk_value_t values_param;
+    awk_value_t first_param;
+    struct rect_array *array;
+    size_t count;
+    int first;
+    int i, n;
+
+    if (! get_argument(0, AWK_STRING, &rects_ptr_param)
+        || ! get_argument(1, AWK_ARRAY, &values_param)
+        || (array = find_rect_array(rects_ptr_param.str_value.str))
+               == NULL
+        || ! get_element_count(values_param.array_cookie, &count)) {
+        warning(ext_id, _("SDL_Gawk_SetRects: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 2) {
+        if (! get_argument(2, AWK_NUMBER, &first_param)) {
+            warning(ext_id, _("SDL_Gawk_SetRects: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        first_param.num_value = 0;
+    }
+
+    first = first_param.num_value;
+
+    if (first < 0 || first >= array->count) {
+        warning(ext_id, _("SDL_Gawk_SetRects: invalid index %d"), first);
+        RETURN_NOK;
+    }
+
+    /* values are x, y, w and h of each rectangle in turn, indexed from 1
+       like the result of split() */
+    n = count / 4;
+    if (n > array->count - first)
+        n = array->count - first;
+
+    for (i = 0; i < n; i++) {
+        SDL_Rect *rect = &array->rects[first + i];
+        int field[4];
+        int j;
+
+        for (j = 0; j < 4; j++) {
+            awk_value_t index, value;
+
+            if (! get_array_element(values_param.array_cookie,
+                                    make_number(i * 4 + j + 1, &index),
+                                    AWK_NUMBER,
+                                    &value))
+                value.num_value = 0;
+            field[j] = value.num_value;
+        }
+
+        rect->x = field[0];
+        rect->y = field[1];
+        rect->w = field[2];
+        rect->h = field[3];
+    }
+
+    return make_number(n, result);
+}
+
+/* SDL_Rect *SDL_Gawk_RectAt(SDL_Rect *rects, int index); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RectAt --- provide a SDL_Gawk_RectAt() function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RectAt(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t rects_ptr_param;
+    awk_value_t index_param;
+    struct rect_array *array;
+    int index;
+    char rect_addr[20];
+
+    if (! get_argument(0, AWK_STRING, &rects_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &index_param)
+        || (array = find_rect_array(rects_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_RectAt: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    index = index_param.num_value;
+
+    if (index < 0 || index >= array->count) {
+        warning(ext_id, _("SDL_Gawk_RectAt: invalid index %d"), index);
+        RETURN_NOK;
+    }
+
+    // NOLINTNEXTLINE
+    snprintf(rect_addr, sizeof(rect_addr), "%p", &array->rects[index]);
+    return make_string_malloc(rect_addr, strlen(rect_addr), result);
+}
+
+/* void SDL_Gawk_FreeRects(SDL_Rect *rects); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_FreeRects --- provide a SDL_Gawk_FreeRects()
+                             function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_FreeRects(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t rects_ptr_param;
+    struct rect_array *array;
+    struct rect_array **prev;
+
+    if (! get_argument(0, AWK_STRING, &rects_ptr_param)
+        || (array = find_rect_array(rects_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_FreeRects: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &rect_arrays; *prev != array; prev = &(*prev)->next)
+        ;
+    *prev = array->next;
+
+    gawk_free(array);
+    RETURN_OK;
+}
+
+/* void SDL_Gawk_UpdateRect(SDL_Rect *rect, int x, int y, int w, int h); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_UpdateRect --- provide a SDL_Gawk_UpdateRect()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_UpdateRect(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t rect_ptr_param;
+    awk_value_t x_param, y_param;
+    awk_value_t w_param, h_param;
+    uintptr_t rect_ptr;
+    int x, y;
+    int w, h;
+    SDL_Rect *rect;
+
+    if (! get_argument(0, AWK_STRING, &rect_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || ! get_argument(3, AWK_NUMBER, &w_param)
+        || ! get_argument(4, AWK_NUMBER, &h_param)) {
+        warning(ext_id, _("SDL_Gawk_UpdateRect: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    rect_ptr = strtoull(rect_ptr_param.str_value.str, (char **)NULL, 16);
+    x = x_param.num_value;
+    y = y_param.num_value;
+    w = w_param.num_value;
+    h = h_param.num_value;
+
+    if (! rect_ptr) {
+        warning(ext_id, _("SDL_Gawk_UpdateRect: invalid rectangle"));
+        RETURN_NOK;
+    }
+
+    rect = (SDL_Rect *)rect_ptr;
 
     rect->x = x;
     rect->y = y;
@@ -2306,6 +3414,308 @@ do_SDL_HasIntersection(int nargs,
                        result);
 }
 
+/* broad-phase collision world: rect indices kept sorted by left edge
+   between calls, so the insertion sort that refreshes the order is
+   close to linear when entities move a little per frame */
+struct collision_world {
+    struct collision_world *next;
+    int count;
+    int capacity;
+    int *order;
+};
+
+static struct collision_world *collision_worlds;
+
+/* find_collision_world --- look up a collision world handle */
+
+static struct collision_world *
+find_collision_world(const char *handle)
+{
+    struct collision_world *world;
+    uintptr_t world_ptr;
+
+    world_ptr = strtoull(handle, (char **)NULL, 16);
+    for (world = collision_worlds; world != NULL; world = world->next)
+        if ((uintptr_t)world == world_ptr)
+            return world;
+
+    return NULL;
+}
+
+/* sort_collision_world --- bring the sweep order up to date with the
+                            current rects, starting over if their number
+                            changed */
+
+static awk_bool_t
+sort_collision_world(struct collision_world *world,
+                     const SDL_Rect *rects,
+                     int count)
+{
+    int i, j;
+
+    if (count != world->count) {
+        if (count > world->capacity) {
+            int *order = gawk_realloc(world->order, sizeof(int) * count);
+
+            if (order == NULL)
+                return awk_false;
+            world->order = order;
+            world->capacity = count;
+        }
+        for (i = 0; i < count; i++)
+            world->order[i] = i;
+        world->count = count;
+    }
+
+    for (i = 1; i < count; i++) {
+        int index = world->order[i];
+        int x = rects[index].x;
+
+        for (j = i; j > 0 && rects[world->order[j - 1]].x > x; j--)
+            world->order[j] = world->order[j - 1];
+        world->order[j] = index;
+    }
+
+    return awk_true;
+}
+
+/* rects_overlap --- same test as SDL_HasIntersection(), empty rects
+                     never overlap */
+
+static int
+rects_overlap(const SDL_Rect *a, const SDL_Rect *b)
+{
+    return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h
+           && b->y < a->y + a->h;
+}
+
+/* get_collision_args --- fetch the world, rects, count and result array
+                          shared by the SDL_Gawk_Collide*() functions */
+
+static awk_bool_t
+get_collision_args(struct collision_world **world,
+                   struct rect_array **array,
+                   int *count,
+                   awk_array_t *hits,
+                   int hits_arg)
+{
+    awk_value_t world_ptr_param;
+    awk_value_t rects_ptr_param;
+    awk_value_t count_param;
+    awk_value_t hits_param;
+
+    if (! get_argument(0, AWK_STRING, &world_ptr_param)
+        || ! get_argument(1, AWK_STRING, &rects_ptr_param)
+        || ! get_argument(2, AWK_NUMBER, &count_param)
+        || ! get_argument(hits_arg, AWK_ARRAY, &hits_param)
+        || (*world = find_collision_world(world_ptr_param.str_value.str))
+               == NULL
+        || (*array = find_rect_array(rects_ptr_param.str_value.str))
+               == NULL)
+        return awk_false;
+
+    *count = count_param.num_value;
+    *hits = hits_param.array_cookie;
+    return *count >= 0 && *count <= (*array)->count;
+}
+
+/* CollisionWorld *SDL_Gawk_CreateCollisionWorld(void); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreateCollisionWorld --- provide a
+                                        SDL_Gawk_CreateCollisionWorld()
+                                        function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreateCollisionWorld(int nargs,
+                                 awk_value_t *result,
+                                 struct awk_ext_func *finfo)
+{
+    struct collision_world *world;
+    char world_addr[20];
+
+    world = gawk_calloc(1, sizeof(struct collision_world));
+    if (world == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreateCollisionWorld failed"));
+        return make_null_string(result);
+    }
+
+    world->next = collision_worlds;
+    collision_worlds = world;
+
+    // NOLINTNEXTLINE
+    snprintf(world_addr, sizeof(world_addr), "%p", world);
+    return make_string_malloc(world_addr, strlen(world_addr), result);
+}
+
+/* int SDL_Gawk_CollidePairs(CollisionWorld *world,
+                             const SDL_Rect *rects, int count,
+                             awk_array_t *pairs); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CollidePairs --- provide a SDL_Gawk_CollidePairs()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CollidePairs(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    struct collision_world *world;
+    struct rect_array *array;
+    awk_array_t pairs;
+    const SDL_Rect *rects;
+    int count;
+    int npairs = 0;
+    int i, j;
+
+    if (! get_collision_args(&world, &array, &count, &pairs, 3)) {
+        warning(ext_id, _("SDL_Gawk_CollidePairs: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    rects = array->rects;
+    if (! sort_collision_world(world, rects, count)) {
+        update_ERRNO_string(_("SDL_Gawk_CollidePairs failed"));
+        RETURN_NOK;
+    }
+
+    clear_array(pairs);
+
+    /* pairs[2k-1] and pairs[2k] hold the 0-based indices of the k-th
+       overlapping pair, lower index first */
+    for (i = 0; i < count; i++) {
+        const SDL_Rect *a = &rects[world->order[i]];
+        int right = a->x + a->w;
+
+        if (a->w <= 0 || a->h <= 0)
+            continue;
+
+        for (j = i + 1; j < count && rects[world->order[j]].x < right; j++) {
+            const SDL_Rect *b = &rects[world->order[j]];
+            awk_value_t index, value;
+            int first, second;
+
+            if (b->w <= 0 || b->h <= 0 || ! rects_overlap(a, b))
+                continue;
+
+            first = world->order[i];
+            second = world->order[j];
+            if (first > second) {
+                int tmp = first;
+
+                first = second;
+                second = tmp;
+            }
+
+            npairs++;
+            set_array_element(pairs,
+                              make_number(npairs * 2 - 1, &index),
+                              make_number(first, &value));
+            set_array_element(pairs,
+                              make_number(npairs * 2, &index),
+                              make_number(second, &value));
+        }
+    }
+
+    return make_number(npairs, result);
+}
+
+/* int SDL_Gawk_CollideRect(CollisionWorld *world,
+                            const SDL_Rect *rects, int count,
+                            const SDL_Rect *rect,
+                            awk_array_t *hits); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CollideRect --- provide a SDL_Gawk_CollideRect()
+                               function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CollideRect(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t rect_ptr_param;
+    struct collision_world *world;
+    struct rect_array *array;
+    awk_array_t hits;
+    const SDL_Rect *rects;
+    const SDL_Rect *rect;
+    int count;
+    int nhits = 0;
+    int i;
+
+    if (! get_collision_args(&world, &array, &count, &hits, 4)
+        || ! get_argument(3, AWK_STRING, &rect_ptr_param)) {
+        warning(ext_id, _("SDL_Gawk_CollideRect: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    rect = (const SDL_Rect *)strtoull(rect_ptr_param.str_value.str,
+                                      (char **)NULL,
+                                      16);
+    if (rect == NULL) {
+        warning(ext_id, _("SDL_Gawk_CollideRect: invalid rectangle"));
+        RETURN_NOK;
+    }
+
+    rects = array->rects;
+    if (! sort_collision_world(world, rects, count)) {
+        update_ERRNO_string(_("SDL_Gawk_CollideRect failed"));
+        RETURN_NOK;
+    }
+
+    clear_array(hits);
+    if (rect->w <= 0 || rect->h <= 0)
+        return make_number(0, result);
+
+    /* hits[k] holds the 0-based index of the k-th rect hit */
+    for (i = 0; i < count && rects[world->order[i]].x < rect->x + rect->w;
+         i++) {
+        const SDL_Rect *a = &rects[world->order[i]];
+        awk_value_t index, value;
+
+        if (a->w <= 0 || a->h <= 0 || ! rects_overlap(a, rect))
+            continue;
+
+        nhits++;
+        set_array_element(hits,
+                          make_number(nhits, &index),
+                          make_number(world->order[i], &value));
+    }
+
+    return make_number(nhits, result);
+}
+
+/* void SDL_Gawk_DestroyCollisionWorld(CollisionWorld *world); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyCollisionWorld --- provide a
+                                         SDL_Gawk_DestroyCollisionWorld()
+                                         function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyCollisionWorld(int nargs,
+                                  awk_value_t *result,
+                                  struct awk_ext_func *finfo)
+{
+    awk_value_t world_ptr_param;
+    struct collision_world *world;
+    struct collision_world **prev;
+
+    if (! get_argument(0, AWK_STRING, &world_ptr_param)
+        || (world = find_collision_world(world_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id,
+                _("SDL_Gawk_DestroyCollisionWorld: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &collision_worlds; *prev != world; prev = &(*prev)->next)
+        ;
+    *prev = world->next;
+
+    gawk_free(world->order);
+    gawk_free(world);
+    RETURN_OK;
+}
+
 /*----- Surface Creation and Simple Drawing --------------------------------*/
 
 /* int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect,
@@ -2791,6 +4201,8 @@ do_SDL_FillRect(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 
 /*----- Event Handling -----------------------------------------------------*/
 
+static struct object_pool event_pool;
+
 /* SDL_Event *SDL_Gawk_AllocEvent(void); */
 // /* It doesn't exist in SDL2 */
 /* do_SDL_Gawk_AllocEvent --- provide a SDL_Gawk_AllocEvent()
@@ -2803,7 +4215,7 @@ do_SDL_Gawk_AllocEvent(int nargs,
 {
     SDL_Event *event;
 
-    event = gawk_malloc(sizeof(SDL_Event));
+    event = pool_alloc(&event_pool, SLOT_USED);
 
     if (event) {
         char event_addr[20];
@@ -2816,174 +4228,5102 @@ do_SDL_Gawk_AllocEvent(int nargs,
     return make_null_string(result);
 }
 
-/* Uint32 SDL_Gawk_GetEventType(SDL_Event *event); */
+/* void SDL_Gawk_FreeEvent(SDL_Event *event); */
 // /* It doesn't exist in SDL2 */
-/* do_SDL_Gawk_GetEventType --- provide a SDL_Gawk_GetEventType()
-                                function for gawk */
+/* do_SDL_Gawk_FreeEvent --- provide a SDL_Gawk_FreeEvent()
+                             function for gawk */
 
 static awk_value_t *
-do_SDL_Gawk_GetEventType(int nargs,
-                         awk_value_t *result,
-                         struct awk_ext_func *finfo)
+do_SDL_Gawk_FreeEvent(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
 {
     awk_value_t event_ptr_param;
-    uintptr_t event_ptr;
+    struct pool_slot *slot;
+
+    if (! get_argument(0, AWK_STRING, &event_ptr_param)) {
+        warning(ext_id, _("SDL_Gawk_FreeEvent: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    slot = pool_find(&event_pool, event_ptr_param.str_value.str);
+
+    if (slot == NULL) {
+        warning(ext_id, _("SDL_Gawk_FreeEvent: invalid event"));
+        RETURN_NOK;
+    }
+
+    pool_free(&event_pool, slot);
+    RETURN_OK;
+}
+
+/* Uint32 SDL_Gawk_GetEventType(SDL_Event *event); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_GetEventType --- provide a SDL_Gawk_GetEventType()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_GetEventType(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t event_ptr_param;
+    uintptr_t event_ptr;
     uint32_t type;
 
-    if (! get_argument(0, AWK_STRING, &event_ptr_param)) {
-        warning(ext_id, _("SDL_Gawk_GetEventType: bad parameter(s)"));
+    if (! get_argument(0, AWK_STRING, &event_ptr_param)) {
+        warning(ext_id, _("SDL_Gawk_GetEventType: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    event_ptr = strtoull(event_ptr_param.str_value.str, (char **)NULL, 16);
+
+    if (! event_ptr) {
+        warning(ext_id, _("SDL_Gawk_GetEventType: invalid event"));
+        RETURN_NOK;
+    }
+
+    type = ((SDL_Event *)event_ptr)->type;
+    return make_number(type, result);
+}
+
+/* int SDL_PollEvent(SDL_Event *event); */
+/* do_SDL_PollEvent --- provide a SDL_PollEvent() function for gawk */
+
+static awk_value_t *
+do_SDL_PollEvent(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t event_ptr_param;
+    uintptr_t event_ptr;
+
+    if (! get_argument(0, AWK_STRING, &event_ptr_param)) {
+        warning(ext_id, _("SDL_PollEvent: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    event_ptr = strtoull(event_ptr_param.str_value.str, (char **)NULL, 16);
+
+    return make_number(SDL_PollEvent((SDL_Event *)event_ptr), result);
+}
+
+/*----- Keyboard Support ---------------------------------------------------*/
+
+/* void SDL_Gawk_GetKeyboardState(int *numkeys, awk_array_t *array); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_GetKeyboardState --- provide a SDL_Gawk_GetKeyboardState()
+                                    function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_GetKeyboardState(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    awk_value_t numkeys_ptr_param;
+    awk_value_t array_param;
+    uintptr_t numkeys_ptr;
+    awk_array_t array;
+    const uint8_t *state;
+    awk_value_t index, value;
+    size_t i;
+
+    if (! get_argument(0, AWK_STRING, &numkeys_ptr_param)
+        || ! get_argument(1, AWK_ARRAY, &array_param)) {
+        warning(ext_id, _("SDL_Gawk_GetKeyboardState: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    numkeys_ptr = strtoull(numkeys_ptr_param.str_value.str,
+                           (char **)NULL,
+                           16);
+    array = array_param.array_cookie;
+
+    state = SDL_GetKeyboardState((int *)numkeys_ptr);
+
+    clear_array(array);
+
+    for (i = 0; i < SDL_NUM_SCANCODES; i++)
+        set_array_element(array,
+                          make_number(i, &index),
+                          make_number(state[i], &value));
+    RETURN_OK;
+}
+
+/*----- Timer Support ------------------------------------------------------*/
+
+/* void SDL_Delay(Uint32 ms); */
+/* do_SDL_Delay --- provide a SDL_Delay() function for gawk */
+
+static awk_value_t *
+do_SDL_Delay(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t ms_param;
+    uint32_t ms;
+
+    if (! get_argument(0, AWK_NUMBER, &ms_param)) {
+        warning(ext_id, _("SDL_Delay: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    ms = ms_param.num_value;
+
+    SDL_Delay(ms);
+    RETURN_OK;
+}
+
+/* Uint32 SDL_GetTicks(void); */
+/* do_SDL_GetTicks --- provide a SDL_GetTicks() function for gawk */
+
+static awk_value_t *
+do_SDL_GetTicks(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    uint32_t ms = SDL_GetTicks();
+    return make_number(ms, result);
+}
+
+/*----- Message boxes ------------------------------------------------------*/
+
+/* int SDL_ShowSimpleMessageBox(Uint32 flags,
+                                const char *title,
+                                const char *message,
+                                SDL_Window *window); */
+/* do_SDL_ShowSimpleMessageBox --- provide a SDL_ShowSimpleMessageBox()
+                                   function for gawk */
+
+static awk_value_t *
+do_SDL_ShowSimpleMessageBox(int nargs,
+                            awk_value_t *result,
+                            struct awk_ext_func *finfo)
+{
+    awk_value_t flags_param;
+    awk_value_t title_param;
+    awk_value_t message_param;
+    awk_value_t window_ptr_param;
+    uint32_t flags;
+    const char *title;
+    const char *message;
+    uintptr_t window_ptr;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &flags_param)
+        || ! get_argument(1, AWK_STRING, &title_param)
+        || ! get_argument(2, AWK_STRING, &message_param)
+        || ! get_argument(3, AWK_STRING, &window_ptr_param)) {
+        warning(ext_id, _("SDL_ShowSimpleMessageBox: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    flags = flags_param.num_value;
+    title = title_param.str_value.str;
+    message = message_param.str_value.str;
+    window_ptr = strtoull(window_ptr_param.str_value.str, (char **)NULL, 16);
+
+    ret = SDL_ShowSimpleMessageBox(flags,
+                                   title,
+                                   message,
+                                   (SDL_Window *)window_ptr);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_ShowSimpleMessageBox failed"));
+
+    return make_number(ret, result);
+}
+
+/*----- Typed Buffers ------------------------------------------------------*/
+
+enum buffer_type { BUFFER_FLOAT32, BUFFER_INT32, BUFFER_UINT8 };
+
+/* packed numeric array owned by the extension; the awk handle is the
+   address of the header, so it stays valid when the data is resized */
+struct typed_buffer {
+    struct typed_buffer *next;
+    enum buffer_type type;
+    size_t length;
+    unsigned long version; /* bumped on every write, for derived caches */
+    void *data;
+};
+
+static struct typed_buffer *typed_buffers;
+static void forget_buffer(const struct typed_buffer *buffer);
+
+static const struct {
+    const char *name;
+    enum buffer_type type;
+    size_t size;
+} buffer_types[] = {
+    { "float32", BUFFER_FLOAT32, sizeof(float) },
+    { "int32", BUFFER_INT32, sizeof(int32_t) },
+    { "uint8", BUFFER_UINT8, sizeof(uint8_t) },
+};
+
+#define MAX_BUFFER_LENGTH (1 << 28)
+
+/* find_buffer --- look up a typed buffer handle */
+
+static struct typed_buffer *
+find_buffer(const char *handle)
+{
+    struct typed_buffer *buffer;
+    uintptr_t buffer_ptr;
+
+    buffer_ptr = strtoull(handle, (char **)NULL, 16);
+    for (buffer = typed_buffers; buffer != NULL; buffer = buffer->next)
+        if ((uintptr_t)buffer == buffer_ptr)
+            return buffer;
+
+    return NULL;
+}
+
+/* get_buffer_argument --- fetch a typed buffer handle argument */
+
+static struct typed_buffer *
+get_buffer_argument(size_t count)
+{
+    awk_value_t buffer_ptr_param;
+
+    if (! get_argument(count, AWK_STRING, &buffer_ptr_param))
+        return NULL;
+
+    return find_buffer(buffer_ptr_param.str_value.str);
+}
+
+/* load_element --- read element i of a buffer as a double */
+
+static double
+load_element(const struct typed_buffer *buffer, size_t i)
+{
+    switch (buffer->type) {
+    case BUFFER_FLOAT32:
+        return ((const float *)buffer->data)[i];
+    case BUFFER_INT32:
+        return ((const int32_t *)buffer->data)[i];
+    default:
+        return ((const uint8_t *)buffer->data)[i];
+    }
+}
+
+/* store_element --- write element i of a buffer, saturating integers to
+                     the range of the element type */
+
+static void
+store_element(struct typed_buffer *buffer, size_t i, double value)
+{
+    switch (buffer->type) {
+    case BUFFER_FLOAT32:
+        ((float *)buffer->data)[i] = value;
+        break;
+    case BUFFER_INT32:
+        if (! (value > INT32_MIN))
+            value = isnan(value) ? 0 : INT32_MIN;
+        else if (value > INT32_MAX)
+            value = INT32_MAX;
+        ((int32_t *)buffer->data)[i] = value;
+        break;
+    default:
+        if (! (value > 0))
+            value = 0;
+        else if (value > 255)
+            value = 255;
+        ((uint8_t *)buffer->data)[i] = value;
+        break;
+    }
+}
+
+/* element_size --- size in bytes of one element of a buffer */
+
+static size_t
+element_size(const struct typed_buffer *buffer)
+{
+    return buffer_types[buffer->type].size;
+}
+
+/* Buffer *SDL_Gawk_CreateBuffer(const char *type, int length); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreateBuffer --- provide a SDL_Gawk_CreateBuffer()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreateBuffer(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t type_param;
+    awk_value_t length_param;
+    struct typed_buffer *buffer;
+    double length;
+    size_t i;
+    char buffer_addr[20];
+
+    if (! get_argument(0, AWK_STRING, &type_param)
+        || ! get_argument(1, AWK_NUMBER, &length_param)) {
+        warning(ext_id, _("SDL_Gawk_CreateBuffer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (i = 0; i < sizeof(buffer_types) / sizeof(buffer_types[0]); i++)
+        if (strcmp(type_param.str_value.str, buffer_types[i].name) == 0)
+            break;
+    length = length_param.num_value;
+
+    if (i == sizeof(buffer_types) / sizeof(buffer_types[0])) {
+        warning(ext_id,
+                _("SDL_Gawk_CreateBuffer: unknown type `%s'"),
+                type_param.str_value.str);
+        RETURN_NOK;
+    }
+    if (! (length >= 0 && length <= MAX_BUFFER_LENGTH)) {
+        warning(ext_id, _("SDL_Gawk_CreateBuffer: invalid length"));
+        RETURN_NOK;
+    }
+
+    buffer = gawk_calloc(1, sizeof(struct typed_buffer));
+    if (buffer == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreateBuffer failed"));
+        return make_null_string(result);
+    }
+
+    buffer->type = buffer_types[i].type;
+    buffer->length = length;
+    buffer->data = gawk_calloc(buffer->length + 1, buffer_types[i].size);
+    if (buffer->data == NULL) {
+        gawk_free(buffer);
+        update_ERRNO_string(_("SDL_Gawk_CreateBuffer failed"));
+        return make_null_string(result);
+    }
+
+    buffer->next = typed_buffers;
+    typed_buffers = buffer;
+
+    // NOLINTNEXTLINE
+    snprintf(buffer_addr, sizeof(buffer_addr), "%p", buffer);
+    return make_string_malloc(buffer_addr, strlen(buffer_addr), result);
+}
+
+/* resize_buffer --- change the length of a buffer, zeroing any new
+                     elements */
+
+static awk_bool_t
+resize_buffer(struct typed_buffer *buffer, size_t length)
+{
+    void *data;
+
+    /* one spare element so that an empty buffer still owns its data */
+    data = gawk_realloc(buffer->data, (length + 1) * element_size(buffer));
+    if (data == NULL)
+        return awk_false;
+
+    if (length > buffer->length)
+        memset((uint8_t *)data + buffer->length * element_size(buffer),
+               0,
+               (length - buffer->length) * element_size(buffer));
+
+    buffer->data = data;
+    buffer->length = length;
+    buffer->version++;
+    return awk_true;
+}
+
+/* void SDL_Gawk_DestroyBuffer(Buffer *buffer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyBuffer --- provide a SDL_Gawk_DestroyBuffer()
+                                 function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyBuffer(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
+{
+    struct typed_buffer *buffer;
+    struct typed_buffer **prev;
+
+    if ((buffer = get_buffer_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_DestroyBuffer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &typed_buffers; *prev != buffer; prev = &(*prev)->next)
+        ;
+    *prev = buffer->next;
+
+    forget_buffer(buffer);
+    gawk_free(buffer->data);
+    gawk_free(buffer);
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_BufferLength(Buffer *buffer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferLength --- provide a SDL_Gawk_BufferLength()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferLength(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    struct typed_buffer *buffer;
+
+    if ((buffer = get_buffer_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_BufferLength: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    return make_number(buffer->length, result);
+}
+
+/* int SDL_Gawk_ResizeBuffer(Buffer *buffer, int length); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ResizeBuffer --- provide a SDL_Gawk_ResizeBuffer()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ResizeBuffer(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t length_param;
+    struct typed_buffer *buffer;
+    double length;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &length_param)) {
+        warning(ext_id, _("SDL_Gawk_ResizeBuffer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    length = length_param.num_value;
+
+    if (! (length >= 0 && length <= MAX_BUFFER_LENGTH)) {
+        warning(ext_id, _("SDL_Gawk_ResizeBuffer: invalid length"));
+        RETURN_NOK;
+    }
+
+    if (! resize_buffer(buffer, length)) {
+        update_ERRNO_string(_("SDL_Gawk_ResizeBuffer failed"));
+        RETURN_NOK;
+    }
+
+    RETURN_OK;
+}
+
+/* double SDL_Gawk_BufferGet(Buffer *buffer, int index); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferGet --- provide a SDL_Gawk_BufferGet()
+                             function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferGet(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t index_param;
+    struct typed_buffer *buffer;
+    double index;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &index_param)) {
+        warning(ext_id, _("SDL_Gawk_BufferGet: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    index = index_param.num_value;
+
+    if (! (index >= 0 && index < buffer->length)) {
+        warning(ext_id, _("SDL_Gawk_BufferGet: invalid index"));
+        RETURN_NOK;
+    }
+
+    return make_number(load_element(buffer, index), result);
+}
+
+/* int SDL_Gawk_BufferSet(Buffer *buffer, int index, double value); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferSet --- provide a SDL_Gawk_BufferSet()
+                             function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferSet(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t index_param;
+    awk_value_t value_param;
+    struct typed_buffer *buffer;
+    double index;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &index_param)
+        || ! get_argument(2, AWK_NUMBER, &value_param)) {
+        warning(ext_id, _("SDL_Gawk_BufferSet: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    index = index_param.num_value;
+
+    if (! (index >= 0 && index < buffer->length)) {
+        warning(ext_id, _("SDL_Gawk_BufferSet: invalid index"));
+        RETURN_NOK;
+    }
+
+    store_element(buffer, index, value_param.num_value);
+    buffer->version++;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_BufferImport(Buffer *buffer, awk_array_t *array,
+                             int first); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferImport --- provide a SDL_Gawk_BufferImport()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferImport(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t array_param;
+    awk_value_t first_param;
+    struct typed_buffer *buffer;
+    size_t count;
+    size_t first;
+    size_t i;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_ARRAY, &array_param)
+        || ! get_element_count(array_param.array_cookie, &count)) {
+        warning(ext_id, _("SDL_Gawk_BufferImport: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 2) {
+        if (! get_argument(2, AWK_NUMBER, &first_param)) {
+            warning(ext_id, _("SDL_Gawk_BufferImport: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        first_param.num_value = 0;
+    }
+
+    if (! (first_param.num_value >= 0
+           && first_param.num_value <= buffer->length)) {
+        warning(ext_id, _("SDL_Gawk_BufferImport: invalid index"));
+        RETURN_NOK;
+    }
+
+    /* array[1..count] goes to buffer[first..], like the result of split() */
+    first = first_param.num_value;
+    if (count > buffer->length - first)
+        count = buffer->length - first;
+
+    for (i = 0; i < count; i++) {
+        awk_value_t index, value;
+
+        if (! get_array_element(array_param.array_cookie,
+                                make_number(i + 1, &index),
+                                AWK_NUMBER,
+                                &value))
+            value.num_value = 0;
+        store_element(buffer, first + i, value.num_value);
+    }
+
+    buffer->version++;
+    return make_number(count, result);
+}
+
+/* int SDL_Gawk_BufferExport(Buffer *buffer, awk_array_t *array,
+                             int first, int count); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferExport --- provide a SDL_Gawk_BufferExport()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferExport(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t array_param;
+    awk_value_t first_param;
+    awk_value_t count_param;
+    struct typed_buffer *buffer;
+    size_t first, count;
+    size_t i;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_ARRAY, &array_param)) {
+        warning(ext_id, _("SDL_Gawk_BufferExport: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 2) {
+        if (! get_argument(2, AWK_NUMBER, &first_param)) {
+            warning(ext_id, _("SDL_Gawk_BufferExport: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        first_param.num_value = 0;
+    }
+
+    if (! (first_param.num_value >= 0
+           && first_param.num_value <= buffer->length)) {
+        warning(ext_id, _("SDL_Gawk_BufferExport: invalid index"));
+        RETURN_NOK;
+    }
+
+    first = first_param.num_value;
+    count = buffer->length - first;
+
+    if (nargs > 3) {
+        if (! get_argument(3, AWK_NUMBER, &count_param)) {
+            warning(ext_id, _("SDL_Gawk_BufferExport: bad parameter(s)"));
+            RETURN_NOK;
+        }
+        if (count_param.num_value < count)
+            count = count_param.num_value > 0 ? count_param.num_value : 0;
+    }
+
+    clear_array(array_param.array_cookie);
+
+    for (i = 0; i < count; i++) {
+        awk_value_t index, value;
+
+        set_array_element(array_param.array_cookie,
+                          make_number(i + 1, &index),
+                          make_number(load_element(buffer, first + i),
+                                      &value));
+    }
+
+    return make_number(count, result);
+}
+
+/* int SDL_Gawk_BufferFill(Buffer *buffer, double value); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferFill --- provide a SDL_Gawk_BufferFill()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferFill(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t value_param;
+    struct typed_buffer *buffer;
+    size_t i;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &value_param)) {
+        warning(ext_id, _("SDL_Gawk_BufferFill: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (buffer->length > 0) {
+        /* convert once, then replicate the bytes of the first element */
+        store_element(buffer, 0, value_param.num_value);
+        for (i = 1; i < buffer->length; i++)
+            memcpy((uint8_t *)buffer->data + i * element_size(buffer),
+                   buffer->data,
+                   element_size(buffer));
+    }
+
+    buffer->version++;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_BufferScale(Buffer *buffer, double a); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferScale --- provide a SDL_Gawk_BufferScale()
+                               function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferScale(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t a_param;
+    struct typed_buffer *buffer;
+    size_t i;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &a_param)) {
+        warning(ext_id, _("SDL_Gawk_BufferScale: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (buffer->type == BUFFER_FLOAT32) {
+        float *data = buffer->data;
+        float a = a_param.num_value;
+
+        for (i = 0; i < buffer->length; i++)
+            data[i] *= a;
+    } else {
+        for (i = 0; i < buffer->length; i++)
+            store_element(buffer,
+                          i,
+                          load_element(buffer, i) * a_param.num_value);
+    }
+
+    buffer->version++;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_BufferClamp(Buffer *buffer, double lo, double hi); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferClamp --- provide a SDL_Gawk_BufferClamp()
+                               function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferClamp(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t lo_param, hi_param;
+    struct typed_buffer *buffer;
+    double lo, hi;
+    size_t i;
+
+    if ((buffer = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &lo_param)
+        || ! get_argument(2, AWK_NUMBER, &hi_param)) {
+        warning(ext_id, _("SDL_Gawk_BufferClamp: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    lo = lo_param.num_value;
+    hi = hi_param.num_value;
+
+    if (! (lo <= hi)) {
+        warning(ext_id, _("SDL_Gawk_BufferClamp: invalid range"));
+        RETURN_NOK;
+    }
+
+    for (i = 0; i < buffer->length; i++) {
+        double value = load_element(buffer, i);
+
+        if (value < lo)
+            store_element(buffer, i, lo);
+        else if (value > hi)
+            store_element(buffer, i, hi);
+    }
+
+    buffer->version++;
+    RETURN_OK;
+}
+
+/* axpy --- y[i] += a * x[i] over the common length, returning it */
+
+static size_t
+axpy(struct typed_buffer *y, double a, const struct typed_buffer *x)
+{
+    size_t n = y->length < x->length ? y->length : x->length;
+    size_t i;
+
+    if (y->type == BUFFER_FLOAT32 && x->type == BUFFER_FLOAT32) {
+        float *yd = y->data;
+        const float *xd = x->data;
+        float af = a;
+
+        for (i = 0; i < n; i++)
+            yd[i] += af * xd[i];
+    } else {
+        for (i = 0; i < n; i++)
+            store_element(y, i, load_element(y, i) + a * load_element(x, i));
+    }
+
+    y->version++;
+    return n;
+}
+
+/* int SDL_Gawk_BufferAdd(Buffer *y, const Buffer *x); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferAdd --- provide a SDL_Gawk_BufferAdd()
+                             function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferAdd(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    struct typed_buffer *y, *x;
+
+    if ((y = get_buffer_argument(0)) == NULL
+        || (x = get_buffer_argument(1)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_BufferAdd: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    return make_number(axpy(y, 1.0, x), result);
+}
+
+/* int SDL_Gawk_BufferAxpy(Buffer *y, double a, const Buffer *x); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferAxpy --- provide a SDL_Gawk_BufferAxpy()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferAxpy(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t a_param;
+    struct typed_buffer *y, *x;
+
+    if ((y = get_buffer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &a_param)
+        || (x = get_buffer_argument(2)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_BufferAxpy: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    return make_number(axpy(y, a_param.num_value, x), result);
+}
+
+/* void *SDL_Gawk_BufferData(Buffer *buffer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BufferData --- provide a SDL_Gawk_BufferData()
+                              function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BufferData(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    struct typed_buffer *buffer;
+    char data_addr[20];
+
+    if ((buffer = get_buffer_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_BufferData: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* valid until the next SDL_Gawk_ResizeBuffer() */
+    // NOLINTNEXTLINE
+    snprintf(data_addr, sizeof(data_addr), "%p", buffer->data);
+    return make_string_malloc(data_addr, strlen(data_addr), result);
+}
+
+/*----- Kinematic Integration ----------------------------------------------*/
+
+static const char *const edge_names[] = { "left", "right", "top", "bottom" };
+
+/* collide_axis --- keep one coordinate of a body inside [lo, hi], either
+                    stopping it or reflecting it; returns the edge hit as
+                    0 (lo) or 1 (hi), or -1 */
+
+static int
+collide_axis(float *pos, float *vel, float lo, float hi, awk_bool_t bounce)
+{
+    int edge;
+
+    if (*pos < lo)
+        edge = 0;
+    else if (*pos > hi)
+        edge = 1;
+    else
+        return -1;
+
+    if (bounce) {
+        *pos = 2 * (edge ? hi : lo) - *pos;
+        *vel = -*vel;
+        /* a body faster than the box is wide could still be outside */
+        if (*pos < lo || *pos > hi)
+            *pos = edge ? hi : lo;
+    } else {
+        *pos = edge ? hi : lo;
+        *vel = 0;
+    }
+
+    return edge;
+}
+
+/* int SDL_Gawk_Integrate(Buffer *x, Buffer *y, Buffer *vx, Buffer *vy,
+                          double dt,
+                          const SDL_Rect *bounds, const char *mode,
+                          int w, int h,
+                          awk_array_t *events); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_Integrate --- provide a SDL_Gawk_Integrate()
+                             function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_Integrate(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t dt_param;
+    awk_value_t bounds_ptr_param;
+    awk_value_t mode_param;
+    awk_value_t w_param, h_param;
+    awk_value_t events_param;
+    struct typed_buffer *x, *y, *vx, *vy;
+    const SDL_Rect *bounds = NULL;
+    awk_bool_t bounce = awk_true;
+    float *px, *py, *pvx, *pvy;
+    float dt;
+    float w = 0, h = 0;
+    size_t n, i;
+    int nevents = 0;
+
+    if ((x = get_buffer_argument(0)) == NULL
+        || (y = get_buffer_argument(1)) == NULL
+        || (vx = get_buffer_argument(2)) == NULL
+        || (vy = get_buffer_argument(3)) == NULL
+        || ! get_argument(4, AWK_NUMBER, &dt_param)) {
+        warning(ext_id, _("SDL_Gawk_Integrate: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (x->type != BUFFER_FLOAT32 || y->type != BUFFER_FLOAT32
+        || vx->type != BUFFER_FLOAT32 || vy->type != BUFFER_FLOAT32) {
+        warning(ext_id, _("SDL_Gawk_Integrate: buffers must be float32"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 5) {
+        if (! get_argument(5, AWK_STRING, &bounds_ptr_param)) {
+            warning(ext_id, _("SDL_Gawk_Integrate: bad parameter(s)"));
+            RETURN_NOK;
+        }
+        bounds = (const SDL_Rect *)strtoull(bounds_ptr_param.str_value.str,
+                                            (char **)NULL,
+                                            16);
+    }
+    if (nargs > 6) {
+        if (! get_argument(6, AWK_STRING, &mode_param)) {
+            warning(ext_id, _("SDL_Gawk_Integrate: bad parameter(s)"));
+            RETURN_NOK;
+        }
+        if (strcmp(mode_param.str_value.str, "clamp") == 0) {
+            bounce = awk_false;
+        } else if (strcmp(mode_param.str_value.str, "bounce") != 0) {
+            warning(ext_id,
+                    _("SDL_Gawk_Integrate: unknown mode `%s'"),
+                    mode_param.str_value.str);
+            RETURN_NOK;
+        }
+    }
+    if (nargs > 7) {
+        if (! get_argument(7, AWK_NUMBER, &w_param)
+            || ! get_argument(8, AWK_NUMBER, &h_param)) {
+            warning(ext_id, _("SDL_Gawk_Integrate: bad parameter(s)"));
+            RETURN_NOK;
+        }
+        w = w_param.num_value;
+        h = h_param.num_value;
+    }
+    if (nargs > 9) {
+        if (! get_argument(9, AWK_ARRAY, &events_param)) {
+            warning(ext_id, _("SDL_Gawk_Integrate: bad parameter(s)"));
+            RETURN_NOK;
+        }
+        clear_array(events_param.array_cookie);
+    }
+
+    n = x->length;
+    if (y->length < n)
+        n = y->length;
+    if (vx->length < n)
+        n = vx->length;
+    if (vy->length < n)
+        n = vy->length;
+
+    px = x->data;
+    py = y->data;
+    pvx = vx->data;
+    pvy = vy->data;
+    dt = dt_param.num_value;
+
+    for (i = 0; i < n; i++) {
+        px[i] += pvx[i] * dt;
+        py[i] += pvy[i] * dt;
+    }
+
+    if (bounds != NULL) {
+        float left = bounds->x;
+        float top = bounds->y;
+        float right = bounds->x + bounds->w - w;
+        float bottom = bounds->y + bounds->h - h;
+
+        for (i = 0; i < n; i++) {
+            int edges[2];
+            int k;
+
+            edges[0] = collide_axis(&px[i], &pvx[i], left, right, bounce);
+            edges[1] = collide_axis(&py[i], &pvy[i], top, bottom, bounce);
+
+            if (nargs <= 9)
+                continue;
+
+            /* events[2k-1] is the 0-based body index and events[2k] the
+               edge it hit */
+            for (k = 0; k < 2; k++) {
+                awk_value_t index, value;
+                const char *edge;
+
+                if (edges[k] < 0)
+                    continue;
+
+                edge = edge_names[k * 2 + edges[k]];
+                nevents++;
+                set_array_element(events_param.array_cookie,
+                                  make_number(nevents * 2 - 1, &index),
+                                  make_number(i, &value));
+                set_array_element(events_param.array_cookie,
+                                  make_number(nevents * 2, &index),
+                                  make_const_string(edge,
+                                                    strlen(edge),
+                                                    &value));
+            }
+        }
+    }
+
+    x->version++;
+    y->version++;
+    if (bounds != NULL) {
+        vx->version++;
+        vy->version++;
+    }
+
+    return make_number(nevents, result);
+}
+
+/* int SDL_Gawk_BuffersToRects(SDL_Rect *rects,
+                               const Buffer *x, const Buffer *y,
+                               int w, int h); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BuffersToRects --- provide a SDL_Gawk_BuffersToRects()
+                                  function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BuffersToRects(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t rects_ptr_param;
+    awk_value_t w_param, h_param;
+    struct rect_array *array;
+    struct typed_buffer *x, *y;
+    size_t n, i;
+    int w, h;
+
+    if (! get_argument(0, AWK_STRING, &rects_ptr_param)
+        || (x = get_buffer_argument(1)) == NULL
+        || (y = get_buffer_argument(2)) == NULL
+        || ! get_argument(3, AWK_NUMBER, &w_param)
+        || ! get_argument(4, AWK_NUMBER, &h_param)
+        || (array = find_rect_array(rects_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_BuffersToRects: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    w = w_param.num_value;
+    h = h_param.num_value;
+
+    n = array->count;
+    if (x->length < n)
+        n = x->length;
+    if (y->length < n)
+        n = y->length;
+
+    for (i = 0; i < n; i++) {
+        array->rects[i].x = lrint(load_element(x, i));
+        array->rects[i].y = lrint(load_element(y, i));
+        array->rects[i].w = w;
+        array->rects[i].h = h;
+    }
+
+    return make_number(n, result);
+}
+
+/*----- Particle Systems ---------------------------------------------------*/
+
+#define MAX_PARTICLES (1 << 20)
+#define MAX_PARTICLE_EMITTERS 16
+
+struct particle_emitter {
+    float x, y;
+    float rate;   /* particles per second */
+    float angle;  /* direction, in degrees clockwise from +x */
+    float spread; /* full width of the emission cone, in degrees */
+    float speed;
+    float life;   /* seconds */
+    float carry;  /* fraction of a particle owed from the last update */
+};
+
+/* particles stored structure-of-arrays, with the geometry for one
+   SDL_RenderGeometry() call kept alongside */
+struct particle_system {
+    struct particle_system *next;
+    int capacity;
+    int count;
+    float *x, *y, *vx, *vy, *age, *life;
+    float gravity_x, gravity_y;
+    float drag;
+    float size;
+    uint32_t seed;
+    int num_emitters;
+    struct particle_emitter emitters[MAX_PARTICLE_EMITTERS];
+    int ramp_length;
+    SDL_Color ramp[1 << MAX_PALETTE_BPP];
+    SDL_Vertex *vertices;
+    int *indices;
+};
+
+static struct particle_system *particle_systems;
+
+/* find_particle_system --- look up a particle system handle */
+
+static struct particle_system *
+find_particle_system(const char *handle)
+{
+    struct particle_system *ps;
+    uintptr_t ps_ptr;
+
+    ps_ptr = strtoull(handle, (char **)NULL, 16);
+    for (ps = particle_systems; ps != NULL; ps = ps->next)
+        if ((uintptr_t)ps == ps_ptr)
+            return ps;
+
+    return NULL;
+}
+
+/* free_particle_system --- release a particle system and its arrays */
+
+static void
+free_particle_system(struct particle_system *ps)
+{
+    gawk_free(ps->x);
+    gawk_free(ps->y);
+    gawk_free(ps->vx);
+    gawk_free(ps->vy);
+    gawk_free(ps->age);
+    gawk_free(ps->life);
+    gawk_free(ps->vertices);
+    gawk_free(ps->indices);
+    gawk_free(ps);
+}
+
+/* next_random --- return the next xorshift32 number in [0.0, 1.0) */
+
+static float
+next_random(uint32_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return (*seed >> 8) * (1.0f / 16777216.0f);
+}
+
+/* get_spec_number --- fetch a numeric element from a spec array */
+
+static double
+get_spec_number(awk_array_t spec, const char *name, double dfltval)
+{
+    awk_value_t index, value;
+
+    if (get_array_element(spec,
+                          make_const_string(name, strlen(name), &index),
+                          AWK_NUMBER,
+                          &value))
+        return value.num_value;
+
+    return dfltval;
+}
+
+/* set_emitter --- update an emitter from the elements present in spec,
+                   leaving it untouched if the result is invalid */
+
+static awk_bool_t
+set_emitter(struct particle_emitter *emitter, awk_array_t spec)
+{
+    struct particle_emitter e = *emitter;
+
+    e.x = get_spec_number(spec, "x", e.x);
+    e.y = get_spec_number(spec, "y", e.y);
+    e.rate = get_spec_number(spec, "rate", e.rate);
+    e.angle = get_spec_number(spec, "angle", e.angle);
+    e.spread = get_spec_number(spec, "spread", e.spread);
+    e.speed = get_spec_number(spec, "speed", e.speed);
+    e.life = get_spec_number(spec, "life", e.life);
+
+    /* particles fade by age / life, so life must be positive */
+    if (! (isfinite(e.x) && isfinite(e.y) && isfinite(e.angle)
+           && isfinite(e.spread) && isfinite(e.speed))
+        || ! (e.rate >= 0 && isfinite(e.rate))
+        || ! (e.life > 0 && isfinite(e.life)))
+        return awk_false;
+
+    *emitter = e;
+    return awk_true;
+}
+
+/* spawn_particles --- start up to count particles at an emitter, with
+                       speed and life drawn from [50%, 100%] of the
+                       emitter's; returns how many were started */
+
+static int
+spawn_particles(struct particle_system *ps,
+                const struct particle_emitter *emitter,
+                int count)
+{
+    int spawned;
+
+    for (spawned = 0; spawned < count && ps->count < ps->capacity;
+         spawned++) {
+        int i = ps->count++;
+        float angle, speed;
+
+        angle = (emitter->angle
+                 + emitter->spread * (next_random(&ps->seed) - 0.5f))
+                * (float)(M_PI / 180.0);
+        speed = emitter->speed * (0.5f + 0.5f * next_random(&ps->seed));
+
+        ps->x[i] = emitter->x;
+        ps->y[i] = emitter->y;
+        ps->vx[i] = cosf(angle) * speed;
+        ps->vy[i] = sinf(angle) * speed;
+        ps->age[i] = 0;
+        ps->life[i] = emitter->life * (0.5f + 0.5f * next_random(&ps->seed));
+    }
+
+    return spawned;
+}
+
+/* ParticleSystem *SDL_Gawk_CreateParticleSystem(int capacity,
+                                                 Uint32 seed); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreateParticleSystem --- provide a
+                                        SDL_Gawk_CreateParticleSystem()
+                                        function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreateParticleSystem(int nargs,
+                                 awk_value_t *result,
+                                 struct awk_ext_func *finfo)
+{
+    awk_value_t capacity_param;
+    awk_value_t seed_param;
+    struct particle_system *ps;
+    int capacity;
+    int i;
+    char ps_addr[20];
+
+    if (! get_argument(0, AWK_NUMBER, &capacity_param)) {
+        warning(ext_id, _("SDL_Gawk_CreateParticleSystem: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 1) {
+        if (! get_argument(1, AWK_NUMBER, &seed_param)) {
+            warning(ext_id,
+                    _("SDL_Gawk_CreateParticleSystem: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        seed_param.num_value = 1;
+    }
+
+    capacity = capacity_param.num_value;
+
+    if (capacity < 1 || capacity > MAX_PARTICLES) {
+        warning(ext_id,
+                _("SDL_Gawk_CreateParticleSystem: invalid capacity %d"),
+                capacity);
+        RETURN_NOK;
+    }
+
+    ps = gawk_calloc(1, sizeof(struct particle_system));
+    if (ps == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreateParticleSystem failed"));
+        return make_null_string(result);
+    }
+
+    ps->capacity = capacity;
+    ps->x = gawk_malloc(sizeof(float) * capacity);
+    ps->y = gawk_malloc(sizeof(float) * capacity);
+    ps->vx = gawk_malloc(sizeof(float) * capacity);
+    ps->vy = gawk_malloc(sizeof(float) * capacity);
+    ps->age = gawk_malloc(sizeof(float) * capacity);
+    ps->life = gawk_malloc(sizeof(float) * capacity);
+    ps->vertices = gawk_calloc(capacity * 4, sizeof(SDL_Vertex));
+    ps->indices = gawk_malloc(sizeof(int) * capacity * 6);
+    if (ps->x == NULL || ps->y == NULL || ps->vx == NULL || ps->vy == NULL
+        || ps->age == NULL || ps->life == NULL || ps->vertices == NULL
+        || ps->indices == NULL) {
+        free_particle_system(ps);
+        update_ERRNO_string(_("SDL_Gawk_CreateParticleSystem failed"));
+        return make_null_string(result);
+    }
+
+    /* two triangles per particle quad, fixed for the system's life */
+    for (i = 0; i < capacity; i++) {
+        ps->indices[i * 6 + 0] = i * 4 + 0;
+        ps->indices[i * 6 + 1] = i * 4 + 1;
+        ps->indices[i * 6 + 2] = i * 4 + 2;
+        ps->indices[i * 6 + 3] = i * 4 + 2;
+        ps->indices[i * 6 + 4] = i * 4 + 3;
+        ps->indices[i * 6 + 5] = i * 4 + 0;
+    }
+
+    ps->size = 2;
+    ps->seed = (uint32_t)seed_param.num_value;
+    if (ps->seed == 0)
+        ps->seed = 1;
+    ps->ramp_length = 1;
+    ps->ramp[0].r = 255;
+    ps->ramp[0].g = 255;
+    ps->ramp[0].b = 255;
+    ps->ramp[0].a = 255;
+
+    ps->next = particle_systems;
+    particle_systems = ps;
+
+    // NOLINTNEXTLINE
+    snprintf(ps_addr, sizeof(ps_addr), "%p", ps);
+    return make_string_malloc(ps_addr, strlen(ps_addr), result);
+}
+
+/* int SDL_Gawk_SetParticleParam(ParticleSystem *ps,
+                                 const char *name, double value); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_SetParticleParam --- provide a SDL_Gawk_SetParticleParam()
+                                    function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_SetParticleParam(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    awk_value_t name_param;
+    awk_value_t value_param;
+    struct particle_system *ps;
+    const char *name;
+    float value;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || ! get_argument(1, AWK_STRING, &name_param)
+        || ! get_argument(2, AWK_NUMBER, &value_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_SetParticleParam: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    name = name_param.str_value.str;
+    value = value_param.num_value;
+
+    if (! isfinite(value)) {
+        warning(ext_id, _("SDL_Gawk_SetParticleParam: invalid value"));
+        RETURN_NOK;
+    }
+
+    if (strcmp(name, "gravity_x") == 0) {
+        ps->gravity_x = value;
+    } else if (strcmp(name, "gravity_y") == 0) {
+        ps->gravity_y = value;
+    } else if (strcmp(name, "drag") == 0 && value >= 0) {
+        ps->drag = value;
+    } else if (strcmp(name, "size") == 0 && value > 0) {
+        ps->size = value;
+    } else {
+        warning(ext_id,
+                _("SDL_Gawk_SetParticleParam: invalid parameter `%s'"),
+                name);
+        RETURN_NOK;
+    }
+
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_SetParticleRamp(ParticleSystem *ps,
+                                const SDL_Color *colors,
+                                int first, int count); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_SetParticleRamp --- provide a SDL_Gawk_SetParticleRamp()
+                                   function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_SetParticleRamp(int nargs,
+                            awk_value_t *result,
+                            struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    awk_value_t colors_ptr_param;
+    awk_value_t first_param;
+    awk_value_t count_param;
+    struct particle_system *ps;
+    struct color_palette *palette;
+    int first, count;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || ! get_argument(1, AWK_STRING, &colors_ptr_param)
+        || ! get_argument(2, AWK_NUMBER, &first_param)
+        || ! get_argument(3, AWK_NUMBER, &count_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str)) == NULL
+        || (palette = find_color_palette(colors_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_SetParticleRamp: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    first = first_param.num_value;
+    count = count_param.num_value;
+
+    if (first < 0 || count < 1 || count > palette->ncolors - first) {
+        warning(ext_id, _("SDL_Gawk_SetParticleRamp: invalid range"));
+        RETURN_NOK;
+    }
+
+    /* the last color is used at birth, the first one at death, so a
+       palette ordered dark to bright (like doomfire's) fades out */
+    memcpy(ps->ramp, palette->colors + first, sizeof(SDL_Color) * count);
+    ps->ramp_length = count;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_AddParticleEmitter(ParticleSystem *ps, awk_array_t *spec); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_AddParticleEmitter --- provide a SDL_Gawk_AddParticleEmitter()
+                                      function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_AddParticleEmitter(int nargs,
+                               awk_value_t *result,
+                               struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    awk_value_t spec_param;
+    struct particle_system *ps;
+    struct particle_emitter *emitter;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || ! get_argument(1, AWK_ARRAY, &spec_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_AddParticleEmitter: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (ps->num_emitters == MAX_PARTICLE_EMITTERS) {
+        warning(ext_id, _("SDL_Gawk_AddParticleEmitter: too many emitters"));
+        RETURN_NOK;
+    }
+
+    emitter = &ps->emitters[ps->num_emitters];
+    memset(emitter, 0, sizeof(*emitter));
+    emitter->angle = -90;
+    emitter->spread = 30;
+    emitter->speed = 100;
+    emitter->life = 1;
+    if (! set_emitter(emitter, spec_param.array_cookie)) {
+        warning(ext_id, _("SDL_Gawk_AddParticleEmitter: invalid spec"));
+        RETURN_NOK;
+    }
+
+    return make_number(ps->num_emitters++, result);
+}
+
+/* int SDL_Gawk_SetParticleEmitter(ParticleSystem *ps, int emitter,
+                                   awk_array_t *spec); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_SetParticleEmitter --- provide a SDL_Gawk_SetParticleEmitter()
+                                      function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_SetParticleEmitter(int nargs,
+                               awk_value_t *result,
+                               struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    awk_value_t emitter_param;
+    awk_value_t spec_param;
+    struct particle_system *ps;
+    int emitter;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &emitter_param)
+        || ! get_argument(2, AWK_ARRAY, &spec_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_SetParticleEmitter: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    emitter = emitter_param.num_value;
+
+    if (emitter < 0 || emitter >= ps->num_emitters) {
+        warning(ext_id,
+                _("SDL_Gawk_SetParticleEmitter: invalid emitter %d"),
+                emitter);
+        RETURN_NOK;
+    }
+
+    if (! set_emitter(&ps->emitters[emitter], spec_param.array_cookie)) {
+        warning(ext_id, _("SDL_Gawk_SetParticleEmitter: invalid spec"));
+        RETURN_NOK;
+    }
+
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_BurstParticles(ParticleSystem *ps, int emitter, int count); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BurstParticles --- provide a SDL_Gawk_BurstParticles()
+                                  function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BurstParticles(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    awk_value_t emitter_param;
+    awk_value_t count_param;
+    struct particle_system *ps;
+    int emitter;
+    int count;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &emitter_param)
+        || ! get_argument(2, AWK_NUMBER, &count_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_BurstParticles: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    emitter = emitter_param.num_value;
+
+    if (emitter < 0 || emitter >= ps->num_emitters) {
+        warning(ext_id,
+                _("SDL_Gawk_BurstParticles: invalid emitter %d"),
+                emitter);
+        RETURN_NOK;
+    }
+
+    count = count_param.num_value < ps->capacity ? count_param.num_value
+                                                 : ps->capacity;
+    return make_number(spawn_particles(ps, &ps->emitters[emitter], count),
+                       result);
+}
+
+/* int SDL_Gawk_UpdateParticles(ParticleSystem *ps, double dt); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_UpdateParticles --- provide a SDL_Gawk_UpdateParticles()
+                                   function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_UpdateParticles(int nargs,
+                            awk_value_t *result,
+                            struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    awk_value_t dt_param;
+    struct particle_system *ps;
+    float dt, damping;
+    float gx, gy;
+    int i;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &dt_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_UpdateParticles: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    dt = dt_param.num_value;
+    if (! isfinite(dt)) {
+        warning(ext_id, _("SDL_Gawk_UpdateParticles: invalid time step"));
+        RETURN_NOK;
+    }
+    if (! (dt > 0))
+        return make_number(ps->count, result);
+
+    /* retire dead particles by moving the last one into their slot */
+    for (i = 0; i < ps->count;) {
+        ps->age[i] += dt;
+        if (ps->age[i] < ps->life[i]) {
+            i++;
+            continue;
+        }
+
+        ps->count--;
+        ps->x[i] = ps->x[ps->count];
+        ps->y[i] = ps->y[ps->count];
+        ps->vx[i] = ps->vx[ps->count];
+        ps->vy[i] = ps->vy[ps->count];
+        ps->age[i] = ps->age[ps->count];
+        ps->life[i] = ps->life[ps->count];
+    }
+
+    damping = expf(-ps->drag * dt);
+    gx = ps->gravity_x * dt;
+    gy = ps->gravity_y * dt;
+    for (i = 0; i < ps->count; i++) {
+        ps->vx[i] = (ps->vx[i] + gx) * damping;
+        ps->vy[i] = (ps->vy[i] + gy) * damping;
+        ps->x[i] += ps->vx[i] * dt;
+        ps->y[i] += ps->vy[i] * dt;
+    }
+
+    for (i = 0; i < ps->num_emitters; i++) {
+        struct particle_emitter *emitter = &ps->emitters[i];
+        int count;
+
+        /* particles that do not fit are dropped, not owed, so a long
+           stall cannot build up a burst (or overflow the int) */
+        emitter->carry += emitter->rate * dt;
+        emitter->carry = SDL_min(emitter->carry, ps->capacity - ps->count);
+        count = emitter->carry;
+        emitter->carry -= count;
+        spawn_particles(ps, emitter, count);
+    }
+
+    return make_number(ps->count, result);
+}
+
+/* int SDL_Gawk_RenderParticles(SDL_Renderer *renderer,
+                                ParticleSystem *ps); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RenderParticles --- provide a SDL_Gawk_RenderParticles()
+                                   function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RenderParticles(int nargs,
+                            awk_value_t *result,
+                            struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t ps_ptr_param;
+    uintptr_t renderer_ptr;
+    struct particle_system *ps;
+    float half;
+    int i;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_STRING, &ps_ptr_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_RenderParticles: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer_ptr = strtoull(renderer_ptr_param.str_value.str,
+                            (char **)NULL,
+                            16);
+
+    if (ps->count == 0)
+        RETURN_OK;
+
+    half = ps->size / 2;
+    for (i = 0; i < ps->count; i++) {
+        SDL_Vertex *v = &ps->vertices[i * 4];
+        int shade;
+
+        shade = (1 - ps->age[i] / ps->life[i]) * ps->ramp_length;
+        if (shade >= ps->ramp_length)
+            shade = ps->ramp_length - 1;
+        else if (shade < 0)
+            shade = 0;
+
+        v[0].position.x = ps->x[i] - half;
+        v[0].position.y = ps->y[i] - half;
+        v[1].position.x = ps->x[i] + half;
+        v[1].position.y = ps->y[i] - half;
+        v[2].position.x = ps->x[i] + half;
+        v[2].position.y = ps->y[i] + half;
+        v[3].position.x = ps->x[i] - half;
+        v[3].position.y = ps->y[i] + half;
+        v[0].color = v[1].color = v[2].color = v[3].color = ps->ramp[shade];
+    }
+
+    ret = SDL_RenderGeometry((SDL_Renderer *)renderer_ptr,
+                             NULL,
+                             ps->vertices, ps->count * 4,
+                             ps->indices, ps->count * 6);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_Gawk_RenderParticles failed"));
+
+    return make_number(ret, result);
+}
+
+/* void SDL_Gawk_DestroyParticleSystem(ParticleSystem *ps); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyParticleSystem --- provide a
+                                         SDL_Gawk_DestroyParticleSystem()
+                                         function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyParticleSystem(int nargs,
+                                  awk_value_t *result,
+                                  struct awk_ext_func *finfo)
+{
+    awk_value_t ps_ptr_param;
+    struct particle_system *ps;
+    struct particle_system **prev;
+
+    if (! get_argument(0, AWK_STRING, &ps_ptr_param)
+        || (ps = find_particle_system(ps_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id,
+                _("SDL_Gawk_DestroyParticleSystem: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &particle_systems; *prev != ps; prev = &(*prev)->next)
+        ;
+    *prev = ps->next;
+
+    free_particle_system(ps);
+    RETURN_OK;
+}
+
+/*----- Bitmap Text --------------------------------------------------------*/
+
+#define ATLAS_COLUMNS 16
+#define ATLAS_ROWS 6
+#define GLYPH_SIZE 8
+
+/* font8x8 glyphs uploaded once per renderer as white-on-transparent
+   texture, tinted through vertex colors */
+struct glyph_atlas {
+    struct glyph_atlas *next;
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+};
+
+static struct glyph_atlas *glyph_atlases;
+
+/* vertex and index storage shared by the text drawing calls */
+static SDL_Vertex *text_vertices;
+static int *text_indices;
+static size_t text_capacity; /* in glyphs */
+
+/* get_glyph_atlas --- return the atlas of a renderer, creating it on
+                       first use */
+
+static struct glyph_atlas *
+get_glyph_atlas(SDL_Renderer *renderer)
+{
+    struct glyph_atlas *atlas;
+    uint32_t pixels[ATLAS_ROWS * GLYPH_SIZE][ATLAS_COLUMNS * GLYPH_SIZE];
+    int c;
+
+    for (atlas = glyph_atlases; atlas != NULL; atlas = atlas->next)
+        if (atlas->renderer == renderer)
+            return atlas;
+
+    memset(pixels, 0, sizeof(pixels));
+    for (c = FONT8X8_FIRST; c <= FONT8X8_LAST; c++) {
+        int cell = c - FONT8X8_FIRST;
+        int x0 = cell % ATLAS_COLUMNS * GLYPH_SIZE;
+        int y0 = cell / ATLAS_COLUMNS * GLYPH_SIZE;
+        int x, y;
+
+        for (y = 0; y < GLYPH_SIZE; y++)
+            for (x = 0; x < GLYPH_SIZE; x++)
+                if (font8x8_basic[cell][y] & (1 << x))
+                    pixels[y0 + y][x0 + x] = 0xFFFFFFFF;
+    }
+
+    atlas = gawk_malloc(sizeof(struct glyph_atlas));
+    if (atlas == NULL)
+        return NULL;
+
+    atlas->renderer = renderer;
+    atlas->texture = SDL_CreateTexture(renderer,
+                                       SDL_PIXELFORMAT_RGBA32,
+                                       SDL_TEXTUREACCESS_STATIC,
+                                       ATLAS_COLUMNS * GLYPH_SIZE,
+                                       ATLAS_ROWS * GLYPH_SIZE);
+    if (atlas->texture == NULL
+        || SDL_UpdateTexture(atlas->texture,
+                             NULL,
+                             pixels,
+                             sizeof(pixels[0]))
+               < 0
+        || SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND)
+               < 0) {
+        if (atlas->texture != NULL)
+            SDL_DestroyTexture(atlas->texture);
+        gawk_free(atlas);
+        return NULL;
+    }
+
+    atlas->next = glyph_atlases;
+    glyph_atlases = atlas;
+    return atlas;
+}
+
+/* reserve_text_vertices --- make room for count glyph quads */
+
+static awk_bool_t
+reserve_text_vertices(size_t count)
+{
+    SDL_Vertex *vertices;
+    int *indices;
+    size_t i;
+
+    if (count <= text_capacity)
+        return awk_true;
+
+    if (count > INT32_MAX / 6)
+        return awk_false;
+
+    vertices = gawk_realloc(text_vertices, sizeof(SDL_Vertex) * count * 4);
+    if (vertices == NULL)
+        return awk_false;
+    text_vertices = vertices;
+
+    indices = gawk_realloc(text_indices, sizeof(int) * count * 6);
+    if (indices == NULL)
+        return awk_false;
+    text_indices = indices;
+
+    for (i = text_capacity; i < count; i++) {
+        text_indices[i * 6 + 0] = i * 4 + 0;
+        text_indices[i * 6 + 1] = i * 4 + 1;
+        text_indices[i * 6 + 2] = i * 4 + 2;
+        text_indices[i * 6 + 3] = i * 4 + 2;
+        text_indices[i * 6 + 4] = i * 4 + 3;
+        text_indices[i * 6 + 5] = i * 4 + 0;
+    }
+
+    text_capacity = count;
+    return awk_true;
+}
+
+/* put_quad --- write an untextured size x size quad at (x, y) into
+                slot n */
+
+static void
+put_quad(size_t n, float x, float y, float size, SDL_Color color)
+{
+    SDL_Vertex *v = &text_vertices[n * 4];
+
+    v[0].position.x = x;
+    v[0].position.y = y;
+    v[1].position.x = x + size;
+    v[1].position.y = y;
+    v[2].position.x = x + size;
+    v[2].position.y = y + size;
+    v[3].position.x = x;
+    v[3].position.y = y + size;
+    v[0].color = v[1].color = v[2].color = v[3].color = color;
+}
+
+/* put_glyph --- write the quad of glyph c at (x, y) into slot n */
+
+static void
+put_glyph(size_t n, int c, float x, float y, float size, SDL_Color color)
+{
+    SDL_Vertex *v = &text_vertices[n * 4];
+    int cell = c - FONT8X8_FIRST;
+    float u0 = (float)(cell % ATLAS_COLUMNS) / ATLAS_COLUMNS;
+    float v0 = (float)(cell / ATLAS_COLUMNS) / ATLAS_ROWS;
+    float u1 = u0 + 1.0f / ATLAS_COLUMNS;
+    float v1 = v0 + 1.0f / ATLAS_ROWS;
+
+    put_quad(n, x, y, size, color);
+    v[0].tex_coord.x = u0;
+    v[0].tex_coord.y = v0;
+    v[1].tex_coord.x = u1;
+    v[1].tex_coord.y = v0;
+    v[2].tex_coord.x = u1;
+    v[2].tex_coord.y = v1;
+    v[3].tex_coord.x = u0;
+    v[3].tex_coord.y = v1;
+}
+
+/* draw_text --- draw len bytes of text at (x, y) in the current draw
+                color with one geometry call */
+
+static int
+draw_text(SDL_Renderer *renderer,
+          float x,
+          float y,
+          const char *text,
+          size_t len,
+          float size)
+{
+    struct glyph_atlas *atlas;
+    SDL_Color color;
+    size_t i, n;
+    float pen_x;
+
+    if ((atlas = get_glyph_atlas(renderer)) == NULL
+        || ! reserve_text_vertices(len)
+        || get_draw_color(renderer, &color.r, &color.g, &color.b, &color.a)
+               < 0)
+        return -1;
+
+    /* '\n' starts a new line, while blanks and bytes outside the font
+       just advance the pen */
+    n = 0;
+    pen_x = x;
+    for (i = 0; i < len; i++) {
+        unsigned char c = text[i];
+
+        if (c == '\n') {
+            pen_x = x;
+            y += size;
+            continue;
+        }
+        if (c > FONT8X8_FIRST && c <= FONT8X8_LAST)
+            put_glyph(n++, c, pen_x, y, size, color);
+        pen_x += size;
+    }
+
+    if (n == 0)
+        return 0;
+
+    return SDL_RenderGeometry(renderer,
+                              atlas->texture,
+                              text_vertices, n * 4,
+                              text_indices, n * 6);
+}
+
+/* int SDL_Gawk_DrawText(SDL_Renderer *renderer, int x, int y,
+                         const char *text, int scale); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DrawText --- provide a SDL_Gawk_DrawText()
+                            function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DrawText(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t x_param, y_param;
+    awk_value_t text_param;
+    awk_value_t scale_param;
+    SDL_Renderer *renderer;
+    const char *text;
+    size_t len;
+    float x, y;
+    float size;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || ! get_argument(3, AWK_STRING, &text_param)) {
+        warning(ext_id, _("SDL_Gawk_DrawText: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 4) {
+        if (! get_argument(4, AWK_NUMBER, &scale_param)) {
+            warning(ext_id, _("SDL_Gawk_DrawText: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        scale_param.num_value = 1;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    x = x_param.num_value;
+    y = y_param.num_value;
+    text = text_param.str_value.str;
+    len = text_param.str_value.len;
+    size = GLYPH_SIZE * scale_param.num_value;
+
+    if (! (size > 0)) {
+        warning(ext_id, _("SDL_Gawk_DrawText: invalid scale"));
+        RETURN_NOK;
+    }
+
+    ret = draw_text(renderer, x, y, text, len, size);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_Gawk_DrawText failed"));
+
+    return make_number(ret, result);
+}
+
+/*----- Text Consoles ------------------------------------------------------*/
+
+#define MAX_CONSOLE_CELLS (1 << 20)
+
+struct console_cell {
+    SDL_Color fg, bg;
+    unsigned char glyph;
+    unsigned char dirty;
+};
+
+/* character grid kept in its own target texture, where only the cells
+   changed since the last SDL_Gawk_RenderConsole() are redrawn; the rows
+   form a ring, so scrolling only moves the origin and blanks one row */
+struct console {
+    struct console *next;
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    int cols, rows;
+    int origin; /* cells and texture row shown at the top */
+    int cursor_x, cursor_y;
+    SDL_Color fg, bg; /* attributes for the next writes */
+    int num_dirty;
+    struct console_cell *cells;
+};
+
+static struct console *consoles;
+
+/* find_console --- look up a console handle */
+
+static struct console *
+find_console(const char *handle)
+{
+    struct console *console;
+    uintptr_t console_ptr;
+
+    console_ptr = strtoull(handle, (char **)NULL, 16);
+    for (console = consoles; console != NULL; console = console->next)
+        if ((uintptr_t)console == console_ptr)
+            return console;
+
+    return NULL;
+}
+
+/* set_cell --- store a glyph with the current attributes */
+
+static void
+set_cell(struct console *console, int x, int y, unsigned char glyph)
+{
+    int row = (console->origin + y) % console->rows;
+    struct console_cell *cell = &console->cells[row * console->cols + x];
+
+    if (cell->glyph == glyph
+        && memcmp(&cell->fg, &console->fg, sizeof(SDL_Color)) == 0
+        && memcmp(&cell->bg, &console->bg, sizeof(SDL_Color)) == 0)
+        return;
+
+    cell->glyph = glyph;
+    cell->fg = console->fg;
+    cell->bg = console->bg;
+    if (! cell->dirty) {
+        cell->dirty = 1;
+        console->num_dirty++;
+    }
+}
+
+/* clear_rows --- blank rows [first, last) with the current attributes */
+
+static void
+clear_rows(struct console *console, int first, int last)
+{
+    int x, y;
+
+    for (y = first; y < last; y++)
+        for (x = 0; x < console->cols; x++)
+            set_cell(console, x, y, ' ');
+}
+
+/* scroll_console --- move every row up by one and blank the last row */
+
+static void
+scroll_console(struct console *console)
+{
+    /* the old top row comes round as the new bottom row */
+    console->origin = (console->origin + 1) % console->rows;
+    clear_rows(console, console->rows - 1, console->rows);
+}
+
+/* rgb_color --- unpack a 0xRRGGBB number into an opaque color */
+
+static SDL_Color
+rgb_color(double rgb)
+{
+    uint32_t bits = rgb;
+    SDL_Color color;
+
+    color.r = (bits >> 16) & 0xFF;
+    color.g = (bits >> 8) & 0xFF;
+    color.b = bits & 0xFF;
+    color.a = 255;
+    return color;
+}
+
+/* Console *SDL_Gawk_CreateConsole(SDL_Renderer *renderer,
+                                   int cols, int rows); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreateConsole --- provide a SDL_Gawk_CreateConsole()
+                                 function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreateConsole(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t cols_param, rows_param;
+    struct console *console;
+    SDL_Renderer *renderer;
+    int cols, rows;
+    char console_addr[20];
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &cols_param)
+        || ! get_argument(2, AWK_NUMBER, &rows_param)) {
+        warning(ext_id, _("SDL_Gawk_CreateConsole: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    cols = cols_param.num_value;
+    rows = rows_param.num_value;
+
+    if (cols < 1 || rows < 1 || cols > MAX_CONSOLE_CELLS / rows) {
+        warning(ext_id, _("SDL_Gawk_CreateConsole: invalid size"));
+        RETURN_NOK;
+    }
+
+    console = gawk_calloc(1, sizeof(struct console));
+    if (console == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreateConsole failed"));
+        return make_null_string(result);
+    }
+
+    console->cells = gawk_calloc(cols * rows, sizeof(struct console_cell));
+    console->texture = SDL_CreateTexture(renderer,
+                                         SDL_PIXELFORMAT_RGBA32,
+                                         SDL_TEXTUREACCESS_TARGET,
+                                         cols * GLYPH_SIZE,
+                                         rows * GLYPH_SIZE);
+    if (console->cells == NULL || console->texture == NULL) {
+        if (console->texture != NULL)
+            SDL_DestroyTexture(console->texture);
+        gawk_free(console->cells);
+        gawk_free(console);
+        update_ERRNO_string(_("SDL_Gawk_CreateConsole failed"));
+        return make_null_string(result);
+    }
+
+    console->renderer = renderer;
+    console->cols = cols;
+    console->rows = rows;
+    console->fg = rgb_color(0xFFFFFF);
+    console->bg = rgb_color(0x000000);
+
+    /* a zeroed cell never matches, so this paints the whole grid once */
+    clear_rows(console, 0, rows);
+
+    console->next = consoles;
+    consoles = console;
+
+    // NOLINTNEXTLINE
+    snprintf(console_addr, sizeof(console_addr), "%p", console);
+    return make_string_malloc(console_addr, strlen(console_addr), result);
+}
+
+/* int SDL_Gawk_ConsoleColor(Console *console, Uint32 fg, Uint32 bg); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ConsoleColor --- provide a SDL_Gawk_ConsoleColor()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ConsoleColor(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t console_ptr_param;
+    awk_value_t fg_param, bg_param;
+    struct console *console;
+
+    if (! get_argument(0, AWK_STRING, &console_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &fg_param)
+        || ! get_argument(2, AWK_NUMBER, &bg_param)
+        || (console = find_console(console_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_ConsoleColor: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    console->fg = rgb_color(fg_param.num_value);
+    console->bg = rgb_color(bg_param.num_value);
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_ConsoleMoveCursor(Console *console, int x, int y); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ConsoleMoveCursor --- provide a SDL_Gawk_ConsoleMoveCursor()
+                                     function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ConsoleMoveCursor(int nargs,
+                              awk_value_t *result,
+                              struct awk_ext_func *finfo)
+{
+    awk_value_t console_ptr_param;
+    awk_value_t x_param, y_param;
+    struct console *console;
+    int x, y;
+
+    if (! get_argument(0, AWK_STRING, &console_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || (console = find_console(console_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_ConsoleMoveCursor: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    x = x_param.num_value;
+    y = y_param.num_value;
+
+    if (x < 0 || x >= console->cols || y < 0 || y >= console->rows) {
+        warning(ext_id, _("SDL_Gawk_ConsoleMoveCursor: invalid position"));
+        RETURN_NOK;
+    }
+
+    console->cursor_x = x;
+    console->cursor_y = y;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_ConsoleWrite(Console *console, const char *text); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ConsoleWrite --- provide a SDL_Gawk_ConsoleWrite()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ConsoleWrite(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t console_ptr_param;
+    awk_value_t text_param;
+    struct console *console;
+    const char *text;
+    size_t i;
+
+    if (! get_argument(0, AWK_STRING, &console_ptr_param)
+        || ! get_argument(1, AWK_STRING, &text_param)
+        || (console = find_console(console_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_ConsoleWrite: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* wrap at the right edge and scroll past the bottom, like a
+       terminal; '\r' returns to the start of the line */
+    text = text_param.str_value.str;
+    for (i = 0; i < text_param.str_value.len; i++) {
+        unsigned char c = text[i];
+
+        if (c == '\r') {
+            console->cursor_x = 0;
+            continue;
+        }
+        if (c != '\n') {
+            if (c < FONT8X8_FIRST || c > FONT8X8_LAST)
+                c = '?';
+            set_cell(console, console->cursor_x, console->cursor_y, c);
+            if (++console->cursor_x < console->cols)
+                continue;
+        }
+
+        console->cursor_x = 0;
+        if (++console->cursor_y == console->rows) {
+            console->cursor_y--;
+            scroll_console(console);
+        }
+    }
+
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_ConsoleClear(Console *console); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ConsoleClear --- provide a SDL_Gawk_ConsoleClear()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ConsoleClear(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t console_ptr_param;
+    struct console *console;
+
+    if (! get_argument(0, AWK_STRING, &console_ptr_param)
+        || (console = find_console(console_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_ConsoleClear: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    clear_rows(console, 0, console->rows);
+    console->cursor_x = 0;
+    console->cursor_y = 0;
+    RETURN_OK;
+}
+
+/* redraw_console --- paint the dirty cells into the console texture,
+                      backgrounds first and then glyphs, one geometry call
+                      each */
+
+static int
+redraw_console(struct console *console, struct glyph_atlas *atlas)
+{
+    SDL_Texture *target;
+    size_t n;
+    int i;
+    int ret;
+
+    if (! reserve_text_vertices(console->num_dirty))
+        return -1;
+
+    target = get_render_target(console->renderer);
+    if (set_render_target(console->renderer, console->texture) < 0)
+        return -1;
+
+    for (i = 0, n = 0; i < console->cols * console->rows; i++)
+        if (console->cells[i].dirty)
+            put_quad(n++,
+                     i % console->cols * GLYPH_SIZE,
+                     i / console->cols * GLYPH_SIZE,
+                     GLYPH_SIZE,
+                     console->cells[i].bg);
+    ret = SDL_RenderGeometry(console->renderer,
+                             NULL,
+                             text_vertices, n * 4,
+                             text_indices, n * 6);
+
+    for (i = 0, n = 0; i < console->cols * console->rows; i++) {
+        struct console_cell *cell = &console->cells[i];
+
+        if (! cell->dirty)
+            continue;
+        cell->dirty = 0;
+        if (cell->glyph > FONT8X8_FIRST)
+            put_glyph(n++,
+                      cell->glyph,
+                      i % console->cols * GLYPH_SIZE,
+                      i / console->cols * GLYPH_SIZE,
+                      GLYPH_SIZE,
+                      cell->fg);
+    }
+    if (ret == 0 && n > 0)
+        ret = SDL_RenderGeometry(console->renderer,
+                                 atlas->texture,
+                                 text_vertices, n * 4,
+                                 text_indices, n * 6);
+
+    console->num_dirty = 0;
+    set_render_target(console->renderer, target);
+    return ret;
+}
+
+/* int SDL_Gawk_RenderConsole(Console *console, int x, int y, int scale); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RenderConsole --- provide a SDL_Gawk_RenderConsole()
+                                 function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RenderConsole(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
+{
+    awk_value_t console_ptr_param;
+    awk_value_t x_param, y_param;
+    awk_value_t scale_param;
+    struct console *console;
+    struct glyph_atlas *atlas;
+    SDL_Rect src, dst;
+    int height;
+    int redrawn;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &console_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || (console = find_console(console_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_RenderConsole: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 3) {
+        if (! get_argument(3, AWK_NUMBER, &scale_param)) {
+            warning(ext_id, _("SDL_Gawk_RenderConsole: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        scale_param.num_value = 1;
+    }
+
+    if (! (scale_param.num_value > 0)) {
+        warning(ext_id, _("SDL_Gawk_RenderConsole: invalid scale"));
+        RETURN_NOK;
+    }
+
+    redrawn = console->num_dirty;
+    if (redrawn > 0
+        && ((atlas = get_glyph_atlas(console->renderer)) == NULL
+            || redraw_console(console, atlas) < 0)) {
+        update_ERRNO_string(_("SDL_Gawk_RenderConsole failed"));
+        RETURN_NOK;
+    }
+
+    /* rows from the origin down first, then the ones wrapped above it */
+    height = console->rows * GLYPH_SIZE * scale_param.num_value;
+    src.x = 0;
+    src.y = console->origin * GLYPH_SIZE;
+    src.w = console->cols * GLYPH_SIZE;
+    src.h = (console->rows - console->origin) * GLYPH_SIZE;
+    dst.x = x_param.num_value;
+    dst.y = y_param.num_value;
+    dst.w = console->cols * GLYPH_SIZE * scale_param.num_value;
+    dst.h = src.h * scale_param.num_value;
+    ret = SDL_RenderCopy(console->renderer, console->texture, &src, &dst);
+    if (ret == 0 && console->origin > 0) {
+        src.y = 0;
+        src.h = console->origin * GLYPH_SIZE;
+        dst.y += dst.h;
+        dst.h = height - dst.h;
+        ret = SDL_RenderCopy(console->renderer, console->texture, &src, &dst);
+    }
+    if (ret < 0) {
+        update_ERRNO_string(_("SDL_Gawk_RenderConsole failed"));
+        RETURN_NOK;
+    }
+
+    /* the number of cells repainted, for budgeting */
+    return make_number(redrawn, result);
+}
+
+/* void SDL_Gawk_DestroyConsole(Console *console); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyConsole --- provide a SDL_Gawk_DestroyConsole()
+                                  function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyConsole(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t console_ptr_param;
+    struct console *console;
+    struct console **prev;
+
+    if (! get_argument(0, AWK_STRING, &console_ptr_param)
+        || (console = find_console(console_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_DestroyConsole: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &consoles; *prev != console; prev = &(*prev)->next)
+        ;
+    *prev = console->next;
+
+    SDL_DestroyTexture(console->texture);
+    gawk_free(console->cells);
+    gawk_free(console);
+    RETURN_OK;
+}
+
+/*----- Time-series Plots --------------------------------------------------*/
+
+#define MAX_PLOT_SERIES 16
+#define MAX_PLOT_SAMPLES (1 << 24)
+#define PLOT_LEVEL0 4 /* log2 of the smallest bucket */
+#define MAX_PLOT_LEVELS 21
+
+/* the range of the finite samples in a run of them, and whether the
+   minimum came first */
+struct plot_bucket {
+    float lo, hi;
+    unsigned char lo_first;
+    unsigned char valid;
+};
+
+struct plot_series {
+    SDL_Color color;
+    size_t head;     /* slot of the next sample */
+    size_t count;    /* samples held, up to the capacity */
+    uint64_t pushed; /* samples ever pushed, numbering the buckets */
+};
+
+/* a strip chart of up to capacity samples per series, the newest at the
+   right edge, kept in one ring buffer per series; each series also keeps
+   rings of buckets summarizing aligned runs of 16, 32, 64... samples, so
+   rendering visits at most 16 buckets per column whatever the capacity */
+struct plot {
+    struct plot *next;
+    int num_series;
+    size_t capacity;
+    double min, max; /* fixed range, or automatic when min >= max */
+    struct plot_series series[MAX_PLOT_SERIES];
+    float *samples; /* num_series rings of capacity floats */
+    int num_levels;
+    size_t level_offset[MAX_PLOT_LEVELS];
+    size_t level_length[MAX_PLOT_LEVELS];
+    size_t buckets_per_series;
+    struct plot_bucket *buckets;
+};
+
+static struct plot *plots;
+
+static SDL_Point *plot_points;
+static size_t plot_points_capacity;
+
+/* find_plot --- look up a plot handle */
+
+static struct plot *
+find_plot(const char *handle)
+{
+    struct plot *plot;
+    uintptr_t plot_ptr;
+
+    plot_ptr = strtoull(handle, (char **)NULL, 16);
+    for (plot = plots; plot != NULL; plot = plot->next)
+        if ((uintptr_t)plot == plot_ptr)
+            return plot;
+
+    return NULL;
+}
+
+/* reserve_plot_points --- make room for count line points */
+
+static awk_bool_t
+reserve_plot_points(size_t count)
+{
+    SDL_Point *points;
+
+    if (count <= plot_points_capacity)
+        return awk_true;
+
+    points = gawk_realloc(plot_points, sizeof(SDL_Point) * count);
+    if (points == NULL)
+        return awk_false;
+
+    plot_points = points;
+    plot_points_capacity = count;
+    return awk_true;
+}
+
+/* get_plot_series --- fetch the plot and series index arguments */
+
+static struct plot_series *
+get_plot_series(struct plot **plot)
+{
+    awk_value_t plot_ptr_param;
+    awk_value_t series_param;
+
+    if (! get_argument(0, AWK_STRING, &plot_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &series_param)
+        || (*plot = find_plot(plot_ptr_param.str_value.str)) == NULL
+        || ! (series_param.num_value >= 0
+              && series_param.num_value < (*plot)->num_series))
+        return NULL;
+
+    return &(*plot)->series[(int)series_param.num_value];
+}
+
+/* merge_sample --- widen a bucket by a finite sample taken after it */
+
+static void
+merge_sample(struct plot_bucket *bucket, float v)
+{
+    if (! bucket->valid) {
+        bucket->lo = bucket->hi = v;
+        bucket->lo_first = 1;
+        bucket->valid = 1;
+    } else if (v < bucket->lo) {
+        bucket->lo = v;
+        bucket->lo_first = 0;
+    } else if (v > bucket->hi) {
+        bucket->hi = v;
+        bucket->lo_first = 1;
+    }
+}
+
+/* merge_bucket --- widen a bucket by the one following it */
+
+static void
+merge_bucket(struct plot_bucket *bucket, const struct plot_bucket *later)
+{
+    int lo_later, hi_later;
+
+    if (! later->valid)
+        return;
+    if (! bucket->valid) {
+        *bucket = *later;
+        return;
+    }
+
+    lo_later = later->lo < bucket->lo;
+    hi_later = later->hi > bucket->hi;
+    if (lo_later && hi_later)
+        bucket->lo_first = later->lo_first;
+    else if (lo_later)
+        bucket->lo_first = 0;
+    else if (hi_later)
+        bucket->lo_first = 1;
+    if (lo_later)
+        bucket->lo = later->lo;
+    if (hi_later)
+        bucket->hi = later->hi;
+}
+
+/* push_sample --- append a sample, overwriting the oldest when full */
+
+static void
+push_sample(struct plot *plot, struct plot_series *series, double value)
+{
+    size_t s = series - plot->series;
+    float *ring = plot->samples + s * plot->capacity;
+    struct plot_bucket *buckets = plot->buckets
+                                  + s * plot->buckets_per_series;
+    uint64_t t = series->pushed++;
+    int level;
+
+    ring[series->head] = value;
+    value = ring[series->head]; /* as stored, out of range is infinite */
+    if (++series->head == plot->capacity)
+        series->head = 0;
+    if (series->count < plot->capacity)
+        series->count++;
+
+    for (level = 0; level < plot->num_levels; level++) {
+        int shift = PLOT_LEVEL0 + level;
+        struct plot_bucket *bucket;
+
+        bucket = buckets + plot->level_offset[level]
+                 + (t >> shift) % plot->level_length[level];
+        if ((t & ((UINT64_C(1) << shift) - 1)) == 0)
+            bucket->valid = 0;
+        if (isfinite(value))
+            merge_sample(bucket, value);
+    }
+}
+
+/* plot_shift --- log2 of the buckets to render w columns from, or 0 to
+                  use the samples themselves */
+
+static int
+plot_shift(const struct plot *plot, int w)
+{
+    size_t per_column = plot->capacity / w;
+    int shift = 0;
+
+    /* the largest buckets that fit eight times in a column, so a bucket
+       straddling two columns moves an extreme by an eighth at most */
+    while (shift + 1 < PLOT_LEVEL0 + plot->num_levels
+           && (size_t)8 << (shift + 1) <= per_column)
+        shift++;
+
+    return shift < PLOT_LEVEL0 ? 0 : shift;
+}
+
+/* next_plot_run --- summarize the run of samples starting at *t, a single
+                     sample or the rest of its bucket, and advance *t */
+
+static void
+next_plot_run(const struct plot *plot,
+              int s,
+              int shift,
+              uint64_t *t,
+              struct plot_bucket *run)
+{
+    const struct plot_series *series = &plot->series[s];
+    const float *ring = plot->samples + s * plot->capacity;
+    uint64_t size = UINT64_C(1) << shift;
+    uint64_t end = (*t / size + 1) * size;
+    size_t slot;
+
+    /* whole buckets come from their level, the oldest one may have lost
+       samples to the ring and is summarized again */
+    if (shift > 0 && *t % size == 0) {
+        *run = plot->buckets[s * plot->buckets_per_series
+                             + plot->level_offset[shift - PLOT_LEVEL0]
+                             + (*t >> shift)
+                                   % plot->level_length[shift
+                                                        - PLOT_LEVEL0]];
+        *t = end;
+        return;
+    }
+
+    if (end > series->pushed)
+        end = series->pushed;
+    run->valid = 0;
+    slot = (series->head + plot->capacity - (series->pushed - *t))
+           % plot->capacity;
+    for (; *t < end; (*t)++) {
+        if (isfinite(ring[slot]))
+            merge_sample(run, ring[slot]);
+        if (++slot == plot->capacity)
+            slot = 0;
+    }
+}
+
+/* Plot *SDL_Gawk_CreatePlot(int num_series, int capacity); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreatePlot --- provide a SDL_Gawk_CreatePlot() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreatePlot(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t num_series_param, capacity_param;
+    struct plot *plot;
+    int i;
+    char plot_addr[20];
+
+    if (! get_argument(0, AWK_NUMBER, &num_series_param)
+        || ! get_argument(1, AWK_NUMBER, &capacity_param)) {
+        warning(ext_id, _("SDL_Gawk_CreatePlot: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (! (num_series_param.num_value >= 1
+           && num_series_param.num_value <= MAX_PLOT_SERIES
+           && capacity_param.num_value >= 1
+           && capacity_param.num_value <= MAX_PLOT_SAMPLES)) {
+        warning(ext_id, _("SDL_Gawk_CreatePlot: invalid size"));
+        RETURN_NOK;
+    }
+
+    plot = gawk_calloc(1, sizeof(struct plot));
+    if (plot == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreatePlot failed"));
+        return make_null_string(result);
+    }
+
+    plot->num_series = num_series_param.num_value;
+    plot->capacity = capacity_param.num_value;
+
+    /* a bucket ring covers the capacity whatever the alignment */
+    while (plot->num_levels < MAX_PLOT_LEVELS
+           && (size_t)1 << (PLOT_LEVEL0 + plot->num_levels)
+                  <= plot->capacity) {
+        i = plot->num_levels++;
+        plot->level_offset[i] = plot->buckets_per_series;
+        plot->level_length[i] = (plot->capacity >> (PLOT_LEVEL0 + i)) + 2;
+        plot->buckets_per_series += plot->level_length[i];
+    }
+
+    plot->samples = gawk_malloc(sizeof(float) * plot->num_series
+                                * plot->capacity);
+    plot->buckets = gawk_calloc(plot->num_series * plot->buckets_per_series
+                                    + 1,
+                                sizeof(struct plot_bucket));
+    if (plot->samples == NULL || plot->buckets == NULL) {
+        gawk_free(plot->samples);
+        gawk_free(plot->buckets);
+        gawk_free(plot);
+        update_ERRNO_string(_("SDL_Gawk_CreatePlot failed"));
+        return make_null_string(result);
+    }
+
+    for (i = 0; i < plot->num_series; i++)
+        plot->series[i].color = rgb_color(0xFFFFFF);
+
+    plot->next = plots;
+    plots = plot;
+
+    // NOLINTNEXTLINE
+    snprintf(plot_addr, sizeof(plot_addr), "%p", plot);
+    return make_string_malloc(plot_addr, strlen(plot_addr), result);
+}
+
+/* int SDL_Gawk_SetPlotRange(Plot *plot, double min, double max); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_SetPlotRange --- provide a SDL_Gawk_SetPlotRange()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_SetPlotRange(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t plot_ptr_param;
+    awk_value_t min_param, max_param;
+    struct plot *plot;
+
+    if (! get_argument(0, AWK_STRING, &plot_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &min_param)
+        || ! get_argument(2, AWK_NUMBER, &max_param)
+        || ! isfinite(min_param.num_value)
+        || ! isfinite(max_param.num_value)
+        || (plot = find_plot(plot_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_SetPlotRange: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* min >= max selects a range fitted to the samples on every render */
+    plot->min = min_param.num_value;
+    plot->max = max_param.num_value;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_SetPlotColor(Plot *plot, int series, Uint32 rgb); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_SetPlotColor --- provide a SDL_Gawk_SetPlotColor()
+                                function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_SetPlotColor(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t rgb_param;
+    struct plot *plot;
+    struct plot_series *series;
+
+    if ((series = get_plot_series(&plot)) == NULL
+        || ! get_argument(2, AWK_NUMBER, &rgb_param)) {
+        warning(ext_id, _("SDL_Gawk_SetPlotColor: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    series->color = rgb_color(rgb_param.num_value);
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_PlotPush(Plot *plot, int series, double value); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_PlotPush --- provide a SDL_Gawk_PlotPush() function for
+                            gawk */
+
+static awk_value_t *
+do_SDL_Gawk_PlotPush(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
+{
+    awk_value_t value_param;
+    struct plot *plot;
+    struct plot_series *series;
+
+    if ((series = get_plot_series(&plot)) == NULL
+        || ! get_argument(2, AWK_NUMBER, &value_param)) {
+        warning(ext_id, _("SDL_Gawk_PlotPush: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    push_sample(plot, series, value_param.num_value);
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_PlotPushArray(Plot *plot, int series, awk_array_t *array); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_PlotPushArray --- provide a SDL_Gawk_PlotPushArray()
+                                 function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_PlotPushArray(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
+{
+    awk_value_t array_param;
+    struct plot *plot;
+    struct plot_series *series;
+    size_t count;
+    size_t i;
+
+    if ((series = get_plot_series(&plot)) == NULL
+        || ! get_argument(2, AWK_ARRAY, &array_param)
+        || ! get_element_count(array_param.array_cookie, &count)) {
+        warning(ext_id, _("SDL_Gawk_PlotPushArray: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* array[1..count] in order, like the result of split(); missing
+       elements leave a gap */
+    for (i = 0; i < count; i++) {
+        awk_value_t index, value;
+
+        if (! get_array_element(array_param.array_cookie,
+                                make_number(i + 1, &index),
+                                AWK_NUMBER,
+                                &value))
+            value.num_value = NAN;
+        push_sample(plot, series, value.num_value);
+    }
+
+    return make_number(count, result);
+}
+
+/* int SDL_Gawk_PlotPushBuffer(Plot *plot, int series, Buffer *buffer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_PlotPushBuffer --- provide a SDL_Gawk_PlotPushBuffer()
+                                  function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_PlotPushBuffer(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    struct plot *plot;
+    struct plot_series *series;
+    struct typed_buffer *buffer;
+    size_t i;
+
+    if ((series = get_plot_series(&plot)) == NULL
+        || (buffer = get_buffer_argument(2)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_PlotPushBuffer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* only the last capacity elements can survive the ring */
+    i = buffer->length > plot->capacity ? buffer->length - plot->capacity
+                                        : 0;
+    for (; i < buffer->length; i++)
+        push_sample(plot, series, load_element(buffer, i));
+
+    return make_number(buffer->length, result);
+}
+
+/* int SDL_Gawk_ClearPlot(Plot *plot); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ClearPlot --- provide a SDL_Gawk_ClearPlot() function for
+                             gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ClearPlot(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t plot_ptr_param;
+    struct plot *plot;
+    int i;
+
+    if (! get_argument(0, AWK_STRING, &plot_ptr_param)
+        || (plot = find_plot(plot_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_ClearPlot: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (i = 0; i < plot->num_series; i++) {
+        plot->series[i].head = 0;
+        plot->series[i].count = 0;
+        plot->series[i].pushed = 0;
+    }
+
+    RETURN_OK;
+}
+
+/* plot_range --- the range of all finite samples; false if there is
+                  none */
+
+static awk_bool_t
+plot_range(const struct plot *plot, int w, double *min, double *max)
+{
+    struct plot_bucket all, run;
+    int shift = plot_shift(plot, w);
+    uint64_t t;
+    int s;
+
+    all.valid = 0;
+    for (s = 0; s < plot->num_series; s++)
+        for (t = plot->series[s].pushed - plot->series[s].count;
+             t < plot->series[s].pushed;) {
+            next_plot_run(plot, s, shift, &t, &run);
+            merge_bucket(&all, &run);
+        }
+
+    *min = all.lo;
+    *max = all.hi;
+    return all.valid;
+}
+
+/* put_plot_column --- add the points of one column, its minimum and
+                       maximum in the order they occurred */
+
+static size_t
+put_plot_column(size_t n,
+                size_t column,
+                const struct plot_bucket *range,
+                const SDL_Rect *area,
+                double min,
+                double scale)
+{
+    double ends[2];
+    int k;
+
+    ends[0] = range->lo_first ? range->lo : range->hi;
+    ends[1] = range->lo_first ? range->hi : range->lo;
+    for (k = 0; k < (range->lo == range->hi ? 1 : 2); k++) {
+        double y = (ends[k] - min) * scale;
+
+        if (y < 0)
+            y = 0;
+        else if (y > area->h - 1)
+            y = area->h - 1;
+        plot_points[n].x = area->x + column;
+        plot_points[n].y = area->y + area->h - 1 - (int)y;
+        n++;
+    }
+
+    return n;
+}
+
+/* decimate_series --- reduce a series to at most two points per pixel
+                       column and return the number of points */
+
+static size_t
+decimate_series(const struct plot *plot,
+                int s,
+                const SDL_Rect *area,
+                double min,
+                double max)
+{
+    const struct plot_series *series = &plot->series[s];
+    double scale = (area->h - 1) / (max - min);
+    int shift = plot_shift(plot, area->w);
+    uint64_t oldest = series->pushed - series->count;
+    uint64_t first = plot->capacity - series->count;
+    uint64_t t;
+    struct plot_bucket range, run;
+    size_t column = SIZE_MAX;
+    size_t n = 0;
+
+    /* a run starting in a column counts wholly towards it */
+    for (t = oldest; t < series->pushed;) {
+        size_t c = (first + t - oldest) * area->w / plot->capacity;
+
+        next_plot_run(plot, s, shift, &t, &run);
+        if (! run.valid)
+            continue;
+        if (c == column) {
+            merge_bucket(&range, &run);
+            continue;
+        }
+        if (column != SIZE_MAX)
+            n = put_plot_column(n, column, &range, area, min, scale);
+        column = c;
+        range = run;
+    }
+    if (column != SIZE_MAX)
+        n = put_plot_column(n, column, &range, area, min, scale);
+
+    return n;
+}
+
+/* int SDL_Gawk_RenderPlot(SDL_Renderer *renderer, Plot *plot,
+                           int x, int y, int w, int h); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RenderPlot --- provide a SDL_Gawk_RenderPlot() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RenderPlot(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t plot_ptr_param;
+    awk_value_t x_param, y_param, w_param, h_param;
+    SDL_Renderer *renderer;
+    struct plot *plot;
+    SDL_Rect area;
+    SDL_Color color;
+    double min, max;
+    size_t total;
+    int s;
+    int ret;
+    char label[32];
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_STRING, &plot_ptr_param)
+        || ! get_argument(2, AWK_NUMBER, &x_param)
+        || ! get_argument(3, AWK_NUMBER, &y_param)
+        || ! get_argument(4, AWK_NUMBER, &w_param)
+        || ! get_argument(5, AWK_NUMBER, &h_param)
+        || (plot = find_plot(plot_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_RenderPlot: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    area.x = x_param.num_value;
+    area.y = y_param.num_value;
+    area.w = w_param.num_value;
+    area.h = h_param.num_value;
+
+    if (area.w < 2 || area.h < 2 || area.w > 1 << 15 || area.h > 1 << 15) {
+        warning(ext_id, _("SDL_Gawk_RenderPlot: invalid size"));
+        RETURN_NOK;
+    }
+
+    if (! reserve_plot_points((size_t)area.w * 2)) {
+        update_ERRNO_string(_("SDL_Gawk_RenderPlot failed"));
+        RETURN_NOK;
+    }
+
+    min = plot->min;
+    max = plot->max;
+    if (min >= max && ! plot_range(plot, area.w, &min, &max))
+        min = max = 0;
+    if (min >= max) {
+        min -= 0.5;
+        max += 0.5;
+    }
+
+    /* the frame and the range labels take the current draw color, which
+       is restored after the series have been drawn in theirs */
+    if (get_draw_color(renderer, &color.r, &color.g, &color.b, &color.a) < 0
+        || SDL_RenderDrawRect(renderer, &area) < 0) {
+        update_ERRNO_string(_("SDL_Gawk_RenderPlot failed"));
+        RETURN_NOK;
+    }
+    // NOLINTNEXTLINE
+    snprintf(label, sizeof(label), "%.6g", max);
+    ret = draw_text(renderer, area.x + 2, area.y + 2,
+                    label, strlen(label), GLYPH_SIZE);
+    // NOLINTNEXTLINE
+    snprintf(label, sizeof(label), "%.6g", min);
+    if (ret == 0)
+        ret = draw_text(renderer, area.x + 2, area.y + area.h - 2 - GLYPH_SIZE,
+                        label, strlen(label), GLYPH_SIZE);
+
+    /* at most 2 * w points per series however many samples it holds */
+    total = 0;
+    for (s = 0; ret == 0 && s < plot->num_series; s++) {
+        const SDL_Color *c = &plot->series[s].color;
+        size_t n = decimate_series(plot, s, &area, min, max);
+
+        if (n == 0)
+            continue;
+        total += n;
+        ret = set_draw_color(renderer, c->r, c->g, c->b, c->a);
+        if (ret == 0)
+            ret = SDL_RenderDrawLines(renderer, plot_points, n);
+    }
+
+    set_draw_color(renderer, color.r, color.g, color.b, color.a);
+    if (ret < 0) {
+        update_ERRNO_string(_("SDL_Gawk_RenderPlot failed"));
+        RETURN_NOK;
+    }
+
+    return make_number(total, result);
+}
+
+/* void SDL_Gawk_DestroyPlot(Plot *plot); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyPlot --- provide a SDL_Gawk_DestroyPlot() function
+                               for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyPlot(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t plot_ptr_param;
+    struct plot *plot;
+    struct plot **prev;
+
+    if (! get_argument(0, AWK_STRING, &plot_ptr_param)
+        || (plot = find_plot(plot_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_DestroyPlot: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &plots; *prev != plot; prev = &(*prev)->next)
+        ;
+    *prev = plot->next;
+
+    gawk_free(plot->samples);
+    gawk_free(plot->buckets);
+    gawk_free(plot);
+    RETURN_OK;
+}
+
+/*----- Heatmaps -----------------------------------------------------------*/
+
+/* fills one row of color indexes, in [0, ncolors), for write_heatmap() */
+typedef void (*heatmap_row_func)(const void *source,
+                                 int y,
+                                 int w,
+                                 int ncolors,
+                                 unsigned char *levels);
+
+static unsigned char *heatmap_levels;
+static int heatmap_levels_capacity;
+
+/* write_heatmap --- map a w x h grid of color indexes through a palette
+                     into the top left corner of a streaming texture */
+
+static int
+write_heatmap(SDL_Texture *texture,
+              int w,
+              int h,
+              const struct color_palette *palette,
+              heatmap_row_func fill_row,
+              const void *source)
+{
+    SDL_PixelFormat *format;
+    SDL_Rect rect;
+    Uint32 lut[1 << MAX_PALETTE_BPP];
+    Uint32 pixel_format;
+    Uint8 *pixels;
+    int tw, th, pitch;
+    int x, y, i;
+
+    if (SDL_QueryTexture(texture, &pixel_format, NULL, &tw, &th) < 0
+        || w > tw || h > th)
+        return -1;
+
+    if (heatmap_levels_capacity < w) {
+        unsigned char *levels = gawk_realloc(heatmap_levels, w);
+
+        if (levels == NULL)
+            return -1;
+        heatmap_levels = levels;
+        heatmap_levels_capacity = w;
+    }
+
+    /* the lookup table holds each palette entry already in the texture's
+       own 32-bit format, so the inner loop is a plain copy */
+    format = SDL_AllocFormat(pixel_format);
+    if (format == NULL)
+        return -1;
+    if (format->BytesPerPixel != 4) {
+        SDL_FreeFormat(format);
+        return -1;
+    }
+    for (i = 0; i < palette->ncolors; i++)
+        lut[i] = SDL_MapRGBA(format,
+                             palette->colors[i].r,
+                             palette->colors[i].g,
+                             palette->colors[i].b,
+                             palette->colors[i].a);
+    SDL_FreeFormat(format);
+
+    rect.x = 0;
+    rect.y = 0;
+    rect.w = w;
+    rect.h = h;
+    if (SDL_LockTexture(texture, &rect, (void **)&pixels, &pitch) < 0)
+        return -1;
+
+    for (y = 0; y < h; y++) {
+        Uint32 *row = (Uint32 *)(pixels + (size_t)y * pitch);
+
+        fill_row(source, y, w, palette->ncolors, heatmap_levels);
+        for (x = 0; x < w; x++)
+            row[x] = lut[heatmap_levels[x]];
+    }
+
+    SDL_UnlockTexture(texture);
+    return 0;
+}
+
+struct heatmap_matrix {
+    const struct typed_buffer *buffer;
+    double min, scale; /* index = (value - min) * scale */
+};
+
+/* quantize_level --- the palette index of a scaled value, clamped */
+
+static unsigned char
+quantize_level(double level, int ncolors)
+{
+    if (! (level > 0)) /* NaN included */
+        return 0;
+    if (level >= ncolors - 1)
+        return ncolors - 1;
+    return (unsigned char)(level + 0.5);
+}
+
+/* fill_matrix_row --- heatmap_row_func for a row-major typed buffer */
+
+static void
+fill_matrix_row(const void *source,
+                int y,
+                int w,
+                int ncolors,
+                unsigned char *levels)
+{
+    const struct heatmap_matrix *matrix = source;
+    const struct typed_buffer *buffer = matrix->buffer;
+    size_t first = (size_t)y * w;
+    int x;
+
+    /* one loop per element type keeps the conversion out of the loop */
+    switch (buffer->type) {
+    case BUFFER_FLOAT32: {
+        const float *data = (const float *)buffer->data + first;
+
+        for (x = 0; x < w; x++)
+            levels[x] = quantize_level((data[x] - matrix->min)
+                                           * matrix->scale,
+                                       ncolors);
+        break;
+    }
+    case BUFFER_INT32: {
+        const int32_t *data = (const int32_t *)buffer->data + first;
+
+        for (x = 0; x < w; x++)
+            levels[x] = quantize_level((data[x] - matrix->min)
+                                           * matrix->scale,
+                                       ncolors);
+        break;
+    }
+    default: {
+        const uint8_t *data = (const uint8_t *)buffer->data + first;
+
+        for (x = 0; x < w; x++)
+            levels[x] = quantize_level((data[x] - matrix->min)
+                                           * matrix->scale,
+                                       ncolors);
+        break;
+    }
+    }
+}
+
+/* int SDL_Gawk_Heatmap(SDL_Texture *texture, Buffer *buffer, int w, int h,
+                        double min, double max, SDL_Color *colors); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_Heatmap --- provide a SDL_Gawk_Heatmap() function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_Heatmap(int nargs,
+                    awk_value_t *result,
+                    struct awk_ext_func *finfo)
+{
+    awk_value_t texture_ptr_param;
+    awk_value_t w_param, h_param;
+    awk_value_t min_param, max_param;
+    awk_value_t colors_ptr_param;
+    SDL_Texture *texture;
+    struct heatmap_matrix matrix;
+    struct color_palette *palette;
+    int w, h;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &texture_ptr_param)
+        || (matrix.buffer = get_buffer_argument(1)) == NULL
+        || ! get_argument(2, AWK_NUMBER, &w_param)
+        || ! get_argument(3, AWK_NUMBER, &h_param)
+        || ! get_argument(4, AWK_NUMBER, &min_param)
+        || ! get_argument(5, AWK_NUMBER, &max_param)
+        || ! get_argument(6, AWK_STRING, &colors_ptr_param)
+        || (palette = find_color_palette(colors_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_Heatmap: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    texture = (SDL_Texture *)strtoull(texture_ptr_param.str_value.str,
+                                      (char **)NULL,
+                                      16);
+    w = w_param.num_value;
+    h = h_param.num_value;
+
+    if (w < 1 || h < 1 || w > 1 << 15 || h > 1 << 15
+        || (size_t)w * h > matrix.buffer->length
+        || ! (min_param.num_value < max_param.num_value)) {
+        warning(ext_id, _("SDL_Gawk_Heatmap: invalid matrix"));
+        RETURN_NOK;
+    }
+
+    matrix.min = min_param.num_value;
+    matrix.scale = (palette->ncolors - 1)
+                   / (max_param.num_value - min_param.num_value);
+
+    ret = write_heatmap(texture, w, h, palette, fill_matrix_row, &matrix);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_Gawk_Heatmap failed"));
+
+    return make_number(ret, result);
+}
+
+/*----- Density Plots ------------------------------------------------------*/
+
+#define MAX_DENSITY_CELLS (1 << 24)
+
+/* hit counts of a scatter plot binned to a fixed grid, usually one cell
+   per pixel, so memory does not grow with the number of points */
+struct density_grid {
+    struct density_grid *next;
+    int w, h;
+    double x0, y0;           /* data coordinates of the bottom left */
+    double x_scale, y_scale; /* cells per data unit */
+    uint32_t max_count;
+    uint32_t *counts; /* row 0 is the top */
+};
+
+static struct density_grid *density_grids;
+
+/* find_density_grid --- look up a density grid handle */
+
+static struct density_grid *
+find_density_grid(const char *handle)
+{
+    struct density_grid *grid;
+    uintptr_t grid_ptr;
+
+    grid_ptr = strtoull(handle, (char **)NULL, 16);
+    for (grid = density_grids; grid != NULL; grid = grid->next)
+        if ((uintptr_t)grid == grid_ptr)
+            return grid;
+
+    return NULL;
+}
+
+/* get_density_grid_argument --- fetch a density grid argument */
+
+static struct density_grid *
+get_density_grid_argument(size_t count)
+{
+    awk_value_t grid_ptr_param;
+
+    if (! get_argument(count, AWK_STRING, &grid_ptr_param))
+        return NULL;
+
+    return find_density_grid(grid_ptr_param.str_value.str);
+}
+
+/* bin_point --- count a point, and tell whether it fell inside */
+
+static awk_bool_t
+bin_point(struct density_grid *grid, double x, double y)
+{
+    double cx = (x - grid->x0) * grid->x_scale;
+    double cy = (y - grid->y0) * grid->y_scale;
+    uint32_t *count;
+
+    if (! (cx >= 0 && cx < grid->w && cy >= 0 && cy < grid->h))
+        return awk_false;
+
+    count = &grid->counts[(grid->h - 1 - (int)cy) * grid->w + (int)cx];
+    if (*count < UINT32_MAX)
+        (*count)++;
+    if (*count > grid->max_count)
+        grid->max_count = *count;
+    return awk_true;
+}
+
+/* DensityGrid *SDL_Gawk_CreateDensityGrid(int w, int h,
+                                           double x_min, double y_min,
+                                           double x_max, double y_max); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreateDensityGrid --- provide a SDL_Gawk_CreateDensityGrid()
+                                     function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreateDensityGrid(int nargs,
+                              awk_value_t *result,
+                              struct awk_ext_func *finfo)
+{
+    awk_value_t w_param, h_param;
+    awk_value_t x_min_param, y_min_param;
+    awk_value_t x_max_param, y_max_param;
+    struct density_grid *grid;
+    int w, h;
+    char grid_addr[20];
+
+    if (! get_argument(0, AWK_NUMBER, &w_param)
+        || ! get_argument(1, AWK_NUMBER, &h_param)
+        || ! get_argument(2, AWK_NUMBER, &x_min_param)
+        || ! get_argument(3, AWK_NUMBER, &y_min_param)
+        || ! get_argument(4, AWK_NUMBER, &x_max_param)
+        || ! get_argument(5, AWK_NUMBER, &y_max_param)) {
+        warning(ext_id, _("SDL_Gawk_CreateDensityGrid: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    w = w_param.num_value;
+    h = h_param.num_value;
+
+    if (w < 1 || h < 1 || w > 1 << 15 || h > 1 << 15
+        || (size_t)w * h > MAX_DENSITY_CELLS
+        || ! (x_min_param.num_value < x_max_param.num_value)
+        || ! (y_min_param.num_value < y_max_param.num_value)) {
+        warning(ext_id, _("SDL_Gawk_CreateDensityGrid: invalid grid"));
+        RETURN_NOK;
+    }
+
+    grid = gawk_calloc(1, sizeof(struct density_grid));
+    if (grid == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreateDensityGrid failed"));
+        return make_null_string(result);
+    }
+
+    grid->counts = gawk_calloc((size_t)w * h, sizeof(uint32_t));
+    if (grid->counts == NULL) {
+        gawk_free(grid);
+        update_ERRNO_string(_("SDL_Gawk_CreateDensityGrid failed"));
+        return make_null_string(result);
+    }
+
+    grid->w = w;
+    grid->h = h;
+    grid->x0 = x_min_param.num_value;
+    grid->y0 = y_min_param.num_value;
+    grid->x_scale = w / (x_max_param.num_value - x_min_param.num_value);
+    grid->y_scale = h / (y_max_param.num_value - y_min_param.num_value);
+
+    grid->next = density_grids;
+    density_grids = grid;
+
+    // NOLINTNEXTLINE
+    snprintf(grid_addr, sizeof(grid_addr), "%p", grid);
+    return make_string_malloc(grid_addr, strlen(grid_addr), result);
+}
+
+/* int SDL_Gawk_DensityAdd(DensityGrid *grid, double x, double y); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DensityAdd --- provide a SDL_Gawk_DensityAdd() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DensityAdd(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t x_param, y_param;
+    struct density_grid *grid;
+
+    if ((grid = get_density_grid_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)) {
+        warning(ext_id, _("SDL_Gawk_DensityAdd: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* 1 if the point was counted, 0 if it fell outside the grid */
+    return make_number(bin_point(grid, x_param.num_value, y_param.num_value),
+                       result);
+}
+
+/* int SDL_Gawk_DensityAddBuffers(DensityGrid *grid,
+                                  Buffer *x, Buffer *y); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DensityAddBuffers --- provide a SDL_Gawk_DensityAddBuffers()
+                                     function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DensityAddBuffers(int nargs,
+                              awk_value_t *result,
+                              struct awk_ext_func *finfo)
+{
+    struct density_grid *grid;
+    struct typed_buffer *x, *y;
+    size_t count, binned;
+    size_t i;
+
+    if ((grid = get_density_grid_argument(0)) == NULL
+        || (x = get_buffer_argument(1)) == NULL
+        || (y = get_buffer_argument(2)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_DensityAddBuffers: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    count = x->length < y->length ? x->length : y->length;
+    binned = 0;
+    for (i = 0; i < count; i++)
+        binned += bin_point(grid, load_element(x, i), load_element(y, i));
+
+    return make_number(binned, result);
+}
+
+/* int SDL_Gawk_ClearDensityGrid(DensityGrid *grid); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_ClearDensityGrid --- provide a SDL_Gawk_ClearDensityGrid()
+                                    function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_ClearDensityGrid(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    struct density_grid *grid;
+
+    if ((grid = get_density_grid_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_ClearDensityGrid: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    memset(grid->counts, 0, sizeof(uint32_t) * grid->w * grid->h);
+    grid->max_count = 0;
+    RETURN_OK;
+}
+
+struct density_source {
+    const struct density_grid *grid;
+    double scale; /* palette entries per log(count) */
+};
+
+/* fill_density_row --- heatmap_row_func for log-scaled hit counts */
+
+static void
+fill_density_row(const void *source,
+                 int y,
+                 int w,
+                 int ncolors,
+                 unsigned char *levels)
+{
+    const struct density_source *density = source;
+    const uint32_t *counts = density->grid->counts + (size_t)y * w;
+    int x;
+
+    for (x = 0; x < w; x++)
+        levels[x] = counts[x] == 0
+                        ? 0
+                        : quantize_level(1 + log(counts[x]) * density->scale,
+                                         ncolors);
+}
+
+/* int SDL_Gawk_RenderDensity(DensityGrid *grid, SDL_Texture *texture,
+                              SDL_Color *colors); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RenderDensity --- provide a SDL_Gawk_RenderDensity()
+                                 function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RenderDensity(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
+{
+    awk_value_t texture_ptr_param;
+    awk_value_t colors_ptr_param;
+    SDL_Texture *texture;
+    struct density_source density;
+    struct color_palette *palette;
+    int ret;
+
+    if ((density.grid = get_density_grid_argument(0)) == NULL
+        || ! get_argument(1, AWK_STRING, &texture_ptr_param)
+        || ! get_argument(2, AWK_STRING, &colors_ptr_param)
+        || (palette = find_color_palette(colors_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("SDL_Gawk_RenderDensity: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    texture = (SDL_Texture *)strtoull(texture_ptr_param.str_value.str,
+                                      (char **)NULL,
+                                      16);
+
+    /* palette entry 0 is for empty cells, 1 for single hits and the last
+       one for the busiest cell */
+    density.scale = density.grid->max_count > 1
+                        ? (palette->ncolors - 2)
+                              / log(density.grid->max_count)
+                        : 0;
+
+    ret = write_heatmap(texture,
+                        density.grid->w,
+                        density.grid->h,
+                        palette,
+                        fill_density_row,
+                        &density);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_Gawk_RenderDensity failed"));
+
+    /* the busiest cell's count, for a legend */
+    return make_number(ret < 0 ? ret : (double)density.grid->max_count,
+                       result);
+}
+
+/* void SDL_Gawk_DestroyDensityGrid(DensityGrid *grid); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyDensityGrid --- provide a
+                                      SDL_Gawk_DestroyDensityGrid()
+                                      function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyDensityGrid(int nargs,
+                               awk_value_t *result,
+                               struct awk_ext_func *finfo)
+{
+    struct density_grid *grid;
+    struct density_grid **prev;
+
+    if ((grid = get_density_grid_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_DestroyDensityGrid: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &density_grids; *prev != grid; prev = &(*prev)->next)
+        ;
+    *prev = grid->next;
+
+    gawk_free(grid->counts);
+    gawk_free(grid);
+    RETURN_OK;
+}
+
+/*----- Downsampling -------------------------------------------------------*/
+
+#define LTTB_CACHE_SIZE 8
+
+/* the points chosen for one (buffers, range, threshold) request, so that
+   redrawing an unchanged view costs no selection pass */
+struct lttb_selection {
+    const struct typed_buffer *x, *y; /* NULL for an unused entry */
+    unsigned long x_version, y_version;
+    size_t first, count, threshold;
+    unsigned long last_used;
+    size_t num_indices;
+    size_t *indices;
+};
+
+static struct lttb_selection lttb_cache[LTTB_CACHE_SIZE];
+static unsigned long lttb_clock;
+
+/* forget_buffer --- drop cached selections made from a buffer that is
+                     being destroyed */
+
+static void
+forget_buffer(const struct typed_buffer *buffer)
+{
+    int i;
+
+    for (i = 0; i < LTTB_CACHE_SIZE; i++)
+        if (lttb_cache[i].x == buffer || lttb_cache[i].y == buffer) {
+            lttb_cache[i].x = NULL;
+            lttb_cache[i].y = NULL;
+        }
+}
+
+/* select_lttb --- pick threshold (>= 3) indexes of [first, first + count)
+                   with Largest-Triangle-Three-Buckets: keep both ends,
+                   and from each bucket between them the point forming the
+                   largest triangle with the previous pick and the average
+                   of the next bucket; a bucket with no finite area is
+                   left out, so fewer indexes may come back */
+
+static size_t
+select_lttb(const struct typed_buffer *x,
+            const struct typed_buffer *y,
+            size_t first,
+            size_t count,
+            size_t threshold,
+            size_t *indices)
+{
+    double every;
+    size_t a, n;
+    size_t i, j;
+
+    if (threshold >= count) {
+        for (i = 0; i < count; i++)
+            indices[i] = first + i;
+        return count;
+    }
+
+    every = (double)(count - 2) / (threshold - 2);
+    a = 0;
+    n = 0;
+    indices[n++] = first;
+
+    for (i = 0; i < threshold - 2; i++) {
+        size_t start = (size_t)(i * every) + 1;
+        size_t end = (size_t)((i + 1) * every) + 1;
+        size_t next_end = (size_t)((i + 2) * every) + 1;
+        double avg_x = 0, avg_y = 0;
+        double ax, ay;
+        double max_area = -1;
+        size_t chosen = 0;
+        size_t m = 0;
+
+        if (next_end > count)
+            next_end = count;
+        for (j = end; j < next_end; j++) {
+            double px = load_element(x, first + j);
+            double py = load_element(y, first + j);
+
+            if (isfinite(px) && isfinite(py)) {
+                avg_x += px;
+                avg_y += py;
+                m++;
+            }
+        }
+        if (m > 0) {
+            avg_x /= m;
+            avg_y /= m;
+        } else {
+            avg_x = load_element(x, first + count - 1);
+            avg_y = load_element(y, first + count - 1);
+        }
+
+        ax = load_element(x, first + a);
+        ay = load_element(y, first + a);
+        for (j = start; j < end; j++) {
+            double px = load_element(x, first + j);
+            double py = load_element(y, first + j);
+            double area = fabs((ax - avg_x) * (py - ay)
+                               - (ax - px) * (avg_y - ay));
+
+            /* NaN areas never win, so gaps are not picked */
+            if (area > max_area) {
+                max_area = area;
+                chosen = j;
+            }
+        }
+        if (max_area < 0)
+            continue;
+
+        indices[n++] = first + chosen;
+        a = chosen;
+    }
+
+    indices[n++] = first + count - 1;
+    return n;
+}
+
+/* lookup_lttb --- return the cached selection for a request, making it
+                   on a miss in place of the least recently used one */
+
+static const struct lttb_selection *
+lookup_lttb(const struct typed_buffer *x,
+            const struct typed_buffer *y,
+            size_t first,
+            size_t count,
+            size_t threshold)
+{
+    struct lttb_selection *entry;
+    size_t *indices;
+    int i, victim;
+
+    victim = 0;
+    for (i = 0; i < LTTB_CACHE_SIZE; i++) {
+        entry = &lttb_cache[i];
+        if (entry->x == x && entry->y == y
+            && entry->x_version == x->version
+            && entry->y_version == y->version
+            && entry->first == first && entry->count == count
+            && entry->threshold == threshold) {
+            entry->last_used = ++lttb_clock;
+            return entry;
+        }
+        if (entry->last_used < lttb_cache[victim].last_used)
+            victim = i;
+    }
+
+    entry = &lttb_cache[victim];
+    indices = gawk_realloc(entry->indices,
+                           sizeof(size_t) * (threshold < count ? threshold
+                                                               : count));
+    if (indices == NULL)
+        return NULL;
+
+    entry->indices = indices;
+    entry->num_indices = select_lttb(x, y, first, count, threshold, indices);
+    entry->x = x;
+    entry->y = y;
+    entry->x_version = x->version;
+    entry->y_version = y->version;
+    entry->first = first;
+    entry->count = count;
+    entry->threshold = threshold;
+    entry->last_used = ++lttb_clock;
+    return entry;
+}
+
+/* get_lttb_arguments --- fetch the x, y, first, count and threshold
+                          arguments shared by the downsampling functions */
+
+static awk_bool_t
+get_lttb_arguments(size_t base,
+                   struct typed_buffer **x,
+                   struct typed_buffer **y,
+                   size_t *first,
+                   size_t *count,
+                   size_t *threshold)
+{
+    awk_value_t first_param, count_param, threshold_param;
+    size_t length;
+
+    if ((*x = get_buffer_argument(base)) == NULL
+        || (*y = get_buffer_argument(base + 1)) == NULL
+        || ! get_argument(base + 2, AWK_NUMBER, &first_param)
+        || ! get_argument(base + 3, AWK_NUMBER, &count_param)
+        || ! get_argument(base + 4, AWK_NUMBER, &threshold_param))
+        return awk_false;
+
+    length = (*x)->length < (*y)->length ? (*x)->length : (*y)->length;
+    if (! (first_param.num_value >= 0 && count_param.num_value >= 1
+           && first_param.num_value + count_param.num_value <= length
+           && threshold_param.num_value >= 3))
+        return awk_false;
+
+    *first = first_param.num_value;
+    *count = count_param.num_value;
+    *threshold = threshold_param.num_value < MAX_BUFFER_LENGTH
+                     ? threshold_param.num_value
+                     : MAX_BUFFER_LENGTH;
+    return awk_true;
+}
+
+/* int SDL_Gawk_DownsampleLTTB(Buffer *x, Buffer *y, int first, int count,
+                               int threshold,
+                               Buffer *out_x, Buffer *out_y); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DownsampleLTTB --- provide a SDL_Gawk_DownsampleLTTB()
+                                  function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DownsampleLTTB(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    struct typed_buffer *x, *y, *out_x, *out_y;
+    const struct lttb_selection *selection;
+    size_t first, count, threshold;
+    size_t i;
+
+    if (! get_lttb_arguments(0, &x, &y, &first, &count, &threshold)
+        || (out_x = get_buffer_argument(5)) == NULL
+        || (out_y = get_buffer_argument(6)) == NULL
+        || out_x == x || out_x == y || out_y == x || out_y == y) {
+        warning(ext_id, _("SDL_Gawk_DownsampleLTTB: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* short ranges are copied whole, so they need only count elements */
+    if (out_x->length < SDL_min(threshold, count)
+        || out_y->length < SDL_min(threshold, count)) {
+        warning(ext_id, _("SDL_Gawk_DownsampleLTTB: output too short"));
+        RETURN_NOK;
+    }
+
+    selection = lookup_lttb(x, y, first, count, threshold);
+    if (selection == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_DownsampleLTTB failed"));
+        RETURN_NOK;
+    }
+
+    for (i = 0; i < selection->num_indices; i++) {
+        store_element(out_x, i, load_element(x, selection->indices[i]));
+        store_element(out_y, i, load_element(y, selection->indices[i]));
+    }
+    out_x->version++;
+    out_y->version++;
+
+    return make_number(selection->num_indices, result);
+}
+
+/* int SDL_Gawk_RenderLTTB(SDL_Renderer *renderer,
+                           Buffer *x, Buffer *y, int first, int count,
+                           int threshold, const SDL_Rect *rect,
+                           double y_min, double y_max); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RenderLTTB --- provide a SDL_Gawk_RenderLTTB() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RenderLTTB(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t rect_ptr_param;
+    awk_value_t y_min_param, y_max_param;
+    SDL_Renderer *renderer;
+    const SDL_Rect *rect;
+    struct typed_buffer *x, *y;
+    const struct lttb_selection *selection;
+    size_t first, count, threshold;
+    double x_min, x_scale, y_min, y_scale;
+    size_t i, n;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_lttb_arguments(1, &x, &y, &first, &count, &threshold)
+        || ! get_argument(6, AWK_STRING, &rect_ptr_param)
+        || ! get_argument(7, AWK_NUMBER, &y_min_param)
+        || ! get_argument(8, AWK_NUMBER, &y_max_param)) {
+        warning(ext_id, _("SDL_Gawk_RenderLTTB: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    rect = (const SDL_Rect *)strtoull(rect_ptr_param.str_value.str,
+                                      (char **)NULL,
+                                      16);
+
+    if (rect == NULL || rect->w < 2 || rect->h < 2
+        || ! (y_min_param.num_value < y_max_param.num_value)) {
+        warning(ext_id, _("SDL_Gawk_RenderLTTB: invalid view"));
+        RETURN_NOK;
+    }
+
+    selection = lookup_lttb(x, y, first, count, threshold);
+    if (selection == NULL
+        || ! reserve_plot_points(selection->num_indices)) {
+        update_ERRNO_string(_("SDL_Gawk_RenderLTTB failed"));
+        RETURN_NOK;
+    }
+
+    /* the range spans the x values of the two ends, left to right */
+    x_min = load_element(x, first);
+    x_scale = load_element(x, first + count - 1) - x_min;
+    x_scale = x_scale != 0 ? (rect->w - 1) / x_scale : 0;
+    y_min = y_min_param.num_value;
+    y_scale = (rect->h - 1) / (y_max_param.num_value - y_min);
+
+    n = 0;
+    for (i = 0; i < selection->num_indices; i++) {
+        double px = (load_element(x, selection->indices[i]) - x_min)
+                    * x_scale;
+        double py = (load_element(y, selection->indices[i]) - y_min)
+                    * y_scale;
+
+        if (! (isfinite(px) && isfinite(py)))
+            continue;
+        if (px < 0)
+            px = 0;
+        else if (px > rect->w - 1)
+            px = rect->w - 1;
+        if (py < 0)
+            py = 0;
+        else if (py > rect->h - 1)
+            py = rect->h - 1;
+        plot_points[n].x = rect->x + (int)px;
+        plot_points[n].y = rect->y + rect->h - 1 - (int)py;
+        n++;
+    }
+
+    ret = n > 0 ? SDL_RenderDrawLines(renderer, plot_points, n) : 0;
+    if (ret < 0) {
+        update_ERRNO_string(_("SDL_Gawk_RenderLTTB failed"));
+        RETURN_NOK;
+    }
+
+    return make_number(n, result);
+}
+
+/*----- Column Loading -----------------------------------------------------*/
+
+#define MAX_MAP_COLUMNS 16
+#define MAX_MAP_THREADS 16
+#define MAX_NUMBER_LENGTH 63
+
+/* the rows [row, row + nrows) of a mapped file, starting at start, parsed
+   by one worker */
+struct column_chunk {
+    const char *start, *end;
+    size_t row;
+    int fs;          /* field separator, or ' ' for runs of blanks */
+    int ncols;
+    const int *cols; /* 1-based field numbers */
+    struct typed_buffer *const *buffers;
+};
+
+/* parse_field --- the number in a field, or NaN if it is empty or not
+                   entirely numeric */
+
+static double
+parse_field(const char *p, const char *end)
+{
+    char number[MAX_NUMBER_LENGTH + 1];
+    char *stop;
+    double value;
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+    if (p == end || end - p > MAX_NUMBER_LENGTH)
+        return NAN;
+
+    /* strtod() needs a terminated string, which the mapping is not */
+    memcpy(number, p, end - p);
+    number[end - p] = '\0';
+    value = strtod(number, &stop);
+    return *stop == '\0' ? value : NAN;
+}
+
+/* next_field --- find the end of the field at p, and the start of the one
+                  after it (NULL at the end of the line) */
+
+static const char *
+next_field(const char *p, const char *eol, int fs, const char **field_end)
+{
+    const char *q;
+
+    if (fs != ' ') {
+        q = memchr(p, fs, eol - p);
+        *field_end = q != NULL ? q : eol;
+        return q != NULL ? q + 1 : NULL;
+    }
+
+    /* awk's default splitting: blanks and tabs separate, and leading ones
+       are ignored (skipped by the caller) */
+    for (q = p; q < eol && *q != ' ' && *q != '\t'; q++)
+        ;
+    *field_end = q;
+    while (q < eol && (*q == ' ' || *q == '\t'))
+        q++;
+    return q < eol ? q : NULL;
+}
+
+/* parse_chunk --- SDL_ThreadFunction storing the wanted columns of every
+                   line of a chunk */
+
+static int
+parse_chunk(void *data)
+{
+    const struct column_chunk *chunk = data;
+    const char *p = chunk->start;
+    size_t row = chunk->row;
+    int k;
+
+    while (p < chunk->end) {
+        const char *eol = memchr(p, '\n', chunk->end - p);
+        const char *field = p;
+        int found = 0;
+        int n;
+
+        if (eol == NULL)
+            eol = chunk->end;
+
+        for (k = 0; k < chunk->ncols; k++)
+            store_element(chunk->buffers[k], row, NAN);
+
+        if (chunk->fs == ' ')
+            while (field < eol && (*field == ' ' || *field == '\t'))
+                field++;
+        if (field == eol)
+            field = NULL;
+
+        for (n = 1; field != NULL && found < chunk->ncols; n++) {
+            const char *field_end;
+            const char *next = next_field(field, eol, chunk->fs, &field_end);
+
+            for (k = 0; k < chunk->ncols; k++)
+                if (chunk->cols[k] == n) {
+                    store_element(chunk->buffers[k],
+                                  row,
+                                  parse_field(field, field_end));
+                    found++;
+                }
+            field = next;
+        }
+
+        row++;
+        p = eol + 1;
+    }
+
+    return 0;
+}
+
+/* count_lines --- the number of lines in [p, end), the last one possibly
+                   without its newline */
+
+static size_t
+count_lines(const char *p, const char *end)
+{
+    size_t lines = 0;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+
+        lines++;
+        if (eol == NULL)
+            break;
+        p = eol + 1;
+    }
+
+    return lines;
+}
+
+/* get_column_arguments --- collect cols[1..n] and buffers[1..n] */
+
+static int
+get_column_arguments(awk_array_t cols_array,
+                     awk_array_t buffers_array,
+                     int *cols,
+                     struct typed_buffer **buffers)
+{
+    size_t count;
+    size_t i;
+
+    if (! get_element_count(cols_array, &count)
+        || count < 1 || count > MAX_MAP_COLUMNS)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        awk_value_t index, col, buffer_ptr;
+
+        if (! get_array_element(cols_array,
+                                make_number(i + 1, &index),
+                                AWK_NUMBER,
+                                &col)
+            || ! (col.num_value >= 1 && col.num_value <= INT32_MAX)
+            || ! get_array_element(buffers_array,
+                                   make_number(i + 1, &index),
+                                   AWK_STRING,
+                                   &buffer_ptr)
+            || (buffers[i] = find_buffer(buffer_ptr.str_value.str)) == NULL)
+            return -1;
+        cols[i] = col.num_value;
+    }
+
+    return count;
+}
+
+/* int SDL_Gawk_MapColumns(const char *path, const char *fs,
+                           awk_array_t *cols, awk_array_t *buffers,
+                           int skip, int nthreads); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_MapColumns --- provide a SDL_Gawk_MapColumns() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_MapColumns(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t path_param, fs_param;
+    awk_value_t cols_param, buffers_param;
+    awk_value_t skip_param, nthreads_param;
+    struct column_chunk chunks[MAX_MAP_THREADS];
+    SDL_Thread *threads[MAX_MAP_THREADS];
+    struct typed_buffer *buffers[MAX_MAP_COLUMNS];
+    int cols[MAX_MAP_COLUMNS];
+    struct stat st;
+    const char *map, *p, *end;
+    size_t rows, skip;
+    int fd, fs, ncols, nthreads;
+    int i, k;
+
+    if (! get_argument(0, AWK_STRING, &path_param)
+        || ! get_argument(1, AWK_STRING, &fs_param)
+        || ! get_argument(2, AWK_ARRAY, &cols_param)
+        || ! get_argument(3, AWK_ARRAY, &buffers_param)
+        || fs_param.str_value.len != 1 || fs_param.str_value.str[0] == '\n'
+        || (ncols = get_column_arguments(cols_param.array_cookie,
+                                         buffers_param.array_cookie,
+                                         cols,
+                                         buffers))
+               < 0) {
+        warning(ext_id, _("SDL_Gawk_MapColumns: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 4) {
+        if (! get_argument(4, AWK_NUMBER, &skip_param)) {
+            warning(ext_id, _("SDL_Gawk_MapColumns: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        skip_param.num_value = 0;
+    }
+
+    if (nargs > 5) {
+        if (! get_argument(5, AWK_NUMBER, &nthreads_param)) {
+            warning(ext_id, _("SDL_Gawk_MapColumns: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        nthreads_param.num_value = 1;
+    }
+
+    for (k = 0; k < ncols; k++)
+        for (i = 0; i < k; i++)
+            if (buffers[i] == buffers[k]) {
+                warning(ext_id, _("SDL_Gawk_MapColumns: buffer used twice"));
+                RETURN_NOK;
+            }
+
+    fs = fs_param.str_value.str[0];
+    nthreads = nthreads_param.num_value;
+    if (nthreads < 1)
+        nthreads = 1;
+    else if (nthreads > MAX_MAP_THREADS)
+        nthreads = MAX_MAP_THREADS;
+
+    fd = open(path_param.str_value.str, O_RDONLY);
+    if (fd < 0) {
+        update_ERRNO_int(errno);
+        RETURN_NOK;
+    }
+    if (fstat(fd, &st) < 0) {
+        update_ERRNO_int(errno);
+        close(fd);
+        RETURN_NOK;
+    }
+
+    /* an empty file has no rows, and cannot be mapped */
+    if (st.st_size == 0) {
+        close(fd);
+        for (k = 0; k < ncols; k++)
+            if (! resize_buffer(buffers[k], 0)) {
+                update_ERRNO_string(_("SDL_Gawk_MapColumns failed"));
+                RETURN_NOK;
+            }
+        return make_number(0, result);
+    }
+
+    /* a file has no more lines than bytes */
+    skip = skip_param.num_value > 0
+               ? SDL_min(skip_param.num_value, (double)st.st_size)
+               : 0;
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        update_ERRNO_int(errno);
+        close(fd);
+        RETURN_NOK;
+    }
+    madvise((void *)map, st.st_size, MADV_SEQUENTIAL);
+    close(fd);
+
+    /* skip the header lines */
+    p = map;
+    end = map + st.st_size;
+    for (; skip > 0 && p < end; skip--) {
+        const char *eol = memchr(p, '\n', end - p);
+
+        p = eol != NULL ? eol + 1 : end;
+    }
+
+    /* cut the rest into chunks on line boundaries and number their first
+       rows, so that the workers can store without coordination */
+    rows = 0;
+    for (i = 0; i < nthreads; i++) {
+        const char *chunk_end = p + (end - p) / (nthreads - i);
+
+        if (chunk_end < end) {
+            chunk_end = memchr(chunk_end, '\n', end - chunk_end);
+            chunk_end = chunk_end != NULL ? chunk_end + 1 : end;
+        }
+
+        chunks[i].start = p;
+        chunks[i].end = chunk_end;
+        chunks[i].row = rows;
+        chunks[i].fs = fs;
+        chunks[i].ncols = ncols;
+        chunks[i].cols = cols;
+        chunks[i].buffers = buffers;
+        rows += count_lines(p, chunk_end);
+        p = chunk_end;
+    }
+
+    if (rows > MAX_BUFFER_LENGTH) {
+        munmap((void *)map, st.st_size);
+        warning(ext_id, _("SDL_Gawk_MapColumns: too many rows"));
+        RETURN_NOK;
+    }
+
+    for (k = 0; k < ncols; k++)
+        if (! resize_buffer(buffers[k], rows)) {
+            munmap((void *)map, st.st_size);
+            update_ERRNO_string(_("SDL_Gawk_MapColumns failed"));
+            RETURN_NOK;
+        }
+
+    /* chunk 0 is parsed here, as is any chunk whose thread failed */
+    for (i = 1; i < nthreads; i++)
+        threads[i] = chunks[i].start < chunks[i].end
+                         ? SDL_CreateThread(parse_chunk,
+                                            "MapColumns",
+                                            &chunks[i])
+                         : NULL;
+    parse_chunk(&chunks[0]);
+    for (i = 1; i < nthreads; i++) {
+        if (threads[i] != NULL)
+            SDL_WaitThread(threads[i], NULL);
+        else
+            parse_chunk(&chunks[i]);
+    }
+
+    munmap((void *)map, st.st_size);
+
+    for (k = 0; k < ncols; k++)
+        buffers[k]->version++;
+
+    return make_number(rows, result);
+}
+
+/*----- Render Layers ------------------------------------------------------*/
+
+/* a render-target texture that holds a finished drawing until it is
+   invalidated, so static content costs one copy per frame */
+struct render_layer {
+    struct render_layer *next;
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    int w, h;
+    int dirty;
+    int drawing;               /* between BeginLayer and EndLayer */
+    SDL_Texture *saved_target; /* to restore in EndLayer */
+};
+
+static struct render_layer *render_layers;
+
+/* find_render_layer --- look up a layer handle */
+
+static struct render_layer *
+find_render_layer(const char *handle)
+{
+    struct render_layer *layer;
+    uintptr_t layer_ptr;
+
+    layer_ptr = strtoull(handle, (char **)NULL, 16);
+    for (layer = render_layers; layer != NULL; layer = layer->next)
+        if ((uintptr_t)layer == layer_ptr)
+            return layer;
+
+    return NULL;
+}
+
+/* get_render_layer_argument --- fetch a layer argument */
+
+static struct render_layer *
+get_render_layer_argument(size_t count)
+{
+    awk_value_t layer_ptr_param;
+
+    if (! get_argument(count, AWK_STRING, &layer_ptr_param))
+        return NULL;
+
+    return find_render_layer(layer_ptr_param.str_value.str);
+}
+
+/* Layer *SDL_Gawk_CreateLayer(SDL_Renderer *renderer, int w, int h); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_CreateLayer --- provide a SDL_Gawk_CreateLayer() function
+                               for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_CreateLayer(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t w_param, h_param;
+    struct render_layer *layer;
+    SDL_Renderer *renderer;
+    int w, h;
+    char layer_addr[20];
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &w_param)
+        || ! get_argument(2, AWK_NUMBER, &h_param)) {
+        warning(ext_id, _("SDL_Gawk_CreateLayer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    w = w_param.num_value;
+    h = h_param.num_value;
+
+    if (w < 1 || h < 1 || w > 1 << 15 || h > 1 << 15) {
+        warning(ext_id, _("SDL_Gawk_CreateLayer: invalid size"));
+        RETURN_NOK;
+    }
+
+    layer = gawk_calloc(1, sizeof(struct render_layer));
+    if (layer == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_CreateLayer failed"));
+        return make_null_string(result);
+    }
+
+    /* blended, so that layers stack over each other */
+    layer->texture = SDL_CreateTexture(renderer,
+                                       SDL_PIXELFORMAT_RGBA32,
+                                       SDL_TEXTUREACCESS_TARGET,
+                                       w, h);
+    if (layer->texture == NULL
+        || SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND)
+               < 0) {
+        if (layer->texture != NULL)
+            SDL_DestroyTexture(layer->texture);
+        gawk_free(layer);
+        update_ERRNO_string(_("SDL_Gawk_CreateLayer failed"));
+        return make_null_string(result);
+    }
+
+    layer->renderer = renderer;
+    layer->w = w;
+    layer->h = h;
+    layer->dirty = 1;
+
+    layer->next = render_layers;
+    render_layers = layer;
+
+    // NOLINTNEXTLINE
+    snprintf(layer_addr, sizeof(layer_addr), "%p", layer);
+    return make_string_malloc(layer_addr, strlen(layer_addr), result);
+}
+
+/* int SDL_Gawk_BeginLayer(Layer *layer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_BeginLayer --- provide a SDL_Gawk_BeginLayer() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_BeginLayer(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    struct render_layer *layer;
+    SDL_Color color;
+
+    if ((layer = get_render_layer_argument(0)) == NULL || layer->drawing) {
+        warning(ext_id, _("SDL_Gawk_BeginLayer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* a clean layer needs no drawing: 0 tells the script to skip it */
+    if (! layer->dirty)
+        return make_number(0, result);
+
+    /* otherwise redirect drawing into the layer, cleared to transparent,
+       until SDL_Gawk_EndLayer() */
+    layer->saved_target = get_render_target(layer->renderer);
+    if (set_render_target(layer->renderer, layer->texture) < 0) {
+        update_ERRNO_string(_("SDL_Gawk_BeginLayer failed"));
+        RETURN_NOK;
+    }
+    if (get_draw_color(layer->renderer,
+                       &color.r, &color.g, &color.b, &color.a)
+            < 0
+        || set_draw_color(layer->renderer, 0, 0, 0, 0) < 0
+        || SDL_RenderClear(layer->renderer) < 0
+        || set_draw_color(layer->renderer,
+                          color.r, color.g, color.b, color.a)
+               < 0) {
+        set_render_target(layer->renderer, layer->saved_target);
+        update_ERRNO_string(_("SDL_Gawk_BeginLayer failed"));
+        RETURN_NOK;
+    }
+
+    layer->drawing = 1;
+    return make_number(1, result);
+}
+
+/* int SDL_Gawk_EndLayer(Layer *layer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_EndLayer --- provide a SDL_Gawk_EndLayer() function for
+                            gawk */
+
+static awk_value_t *
+do_SDL_Gawk_EndLayer(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
+{
+    struct render_layer *layer;
+    int ret;
+
+    if ((layer = get_render_layer_argument(0)) == NULL || ! layer->drawing) {
+        warning(ext_id, _("SDL_Gawk_EndLayer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    layer->drawing = 0;
+    layer->dirty = 0;
+
+    ret = set_render_target(layer->renderer, layer->saved_target);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_Gawk_EndLayer failed"));
+
+    return make_number(ret, result);
+}
+
+/* int SDL_Gawk_InvalidateLayer(Layer *layer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_InvalidateLayer --- provide a SDL_Gawk_InvalidateLayer()
+                                   function for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_InvalidateLayer(int nargs,
+                            awk_value_t *result,
+                            struct awk_ext_func *finfo)
+{
+    struct render_layer *layer;
+
+    if ((layer = get_render_layer_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_InvalidateLayer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    layer->dirty = 1;
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_RenderLayer(Layer *layer, int x, int y); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_RenderLayer --- provide a SDL_Gawk_RenderLayer() function
+                               for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_RenderLayer(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t x_param, y_param;
+    struct render_layer *layer;
+    SDL_Rect dst;
+    int ret;
+
+    if ((layer = get_render_layer_argument(0)) == NULL
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || layer->drawing) {
+        warning(ext_id, _("SDL_Gawk_RenderLayer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    dst.x = x_param.num_value;
+    dst.y = y_param.num_value;
+    dst.w = layer->w;
+    dst.h = layer->h;
+
+    ret = SDL_RenderCopy(layer->renderer, layer->texture, NULL, &dst);
+    if (ret < 0)
+        update_ERRNO_string(_("SDL_Gawk_RenderLayer failed"));
+
+    return make_number(ret, result);
+}
+
+/* void SDL_Gawk_DestroyLayer(Layer *layer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_DestroyLayer --- provide a SDL_Gawk_DestroyLayer() function
+                                for gawk */
+
+static awk_value_t *
+do_SDL_Gawk_DestroyLayer(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    struct render_layer *layer;
+    struct render_layer **prev;
+
+    if ((layer = get_render_layer_argument(0)) == NULL) {
+        warning(ext_id, _("SDL_Gawk_DestroyLayer: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (prev = &render_layers; *prev != layer; prev = &(*prev)->next)
+        ;
+    *prev = layer->next;
+
+    if (layer->drawing)
+        set_render_target(layer->renderer, layer->saved_target);
+    SDL_DestroyTexture(layer->texture);
+    gawk_free(layer);
+    RETURN_OK;
+}
+
+/*----- Primitive Queues ---------------------------------------------------*/
+
+#define MAX_QUEUED_PRIMITIVES (1 << 24)
+
+static SDL_Rect *flush_rects;
+static size_t flush_rects_capacity;
+
+/* queue_primitive --- append a primitive to a renderer's queue */
+
+static awk_bool_t
+queue_primitive(SDL_Renderer *renderer,
+                enum primitive_kind kind,
+                SDL_Color color,
+                const SDL_Rect *rect)
+{
+    struct renderer_state *state = get_renderer_state(renderer);
+    struct queued_primitive *primitive;
+
+    if (state == NULL || state->num_queued == MAX_QUEUED_PRIMITIVES)
+        return awk_false;
+
+    if (state->num_queued == state->queue_capacity) {
+        size_t capacity = state->queue_capacity ? state->queue_capacity * 2
+                                                : 256;
+        struct queued_primitive *queue
+            = gawk_realloc(state->queue,
+                           sizeof(struct queued_primitive) * capacity);
+
+        if (queue == NULL)
+            return awk_false;
+        state->queue = queue;
+        state->queue_capacity = capacity;
+    }
+
+    primitive = &state->queue[state->num_queued];
+    primitive->color = color;
+    primitive->kind = kind;
+    primitive->seq = state->num_queued++;
+    primitive->rect = *rect;
+    return awk_true;
+}
+
+/* compare_primitives --- qsort() order: by color, then kind, then the
+                          order of queueing */
+
+static int
+compare_primitives(const void *p1, const void *p2)
+{
+    const struct queued_primitive *a = p1;
+    const struct queued_primitive *b = p2;
+    uint32_t color_a = (uint32_t)a->color.r << 24 | a->color.g << 16
+                       | a->color.b << 8 | a->color.a;
+    uint32_t color_b = (uint32_t)b->color.r << 24 | b->color.g << 16
+                       | b->color.b << 8 | b->color.a;
+
+    if (color_a != color_b)
+        return color_a < color_b ? -1 : 1;
+    if (a->kind != b->kind)
+        return a->kind < b->kind ? -1 : 1;
+    return a->seq < b->seq ? -1 : a->seq > b->seq;
+}
+
+/* int SDL_Gawk_QueueRect(SDL_Renderer *renderer, int x, int y, int w, int h,
+                          Uint32 rgb, int fill); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_QueueRect --- provide a SDL_Gawk_QueueRect() function for
+                             gawk */
+
+static awk_value_t *
+do_SDL_Gawk_QueueRect(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t x_param, y_param, w_param, h_param;
+    awk_value_t rgb_param;
+    awk_value_t fill_param;
+    SDL_Renderer *renderer;
+    SDL_Rect rect;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || ! get_argument(3, AWK_NUMBER, &w_param)
+        || ! get_argument(4, AWK_NUMBER, &h_param)
+        || ! get_argument(5, AWK_NUMBER, &rgb_param)) {
+        warning(ext_id, _("SDL_Gawk_QueueRect: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 6) {
+        if (! get_argument(6, AWK_NUMBER, &fill_param)) {
+            warning(ext_id, _("SDL_Gawk_QueueRect: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        fill_param.num_value = 1;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    rect.x = x_param.num_value;
+    rect.y = y_param.num_value;
+    rect.w = w_param.num_value;
+    rect.h = h_param.num_value;
+
+    if (! queue_primitive(renderer,
+                          fill_param.num_value != 0 ? PRIMITIVE_FILL_RECT
+                                                    : PRIMITIVE_DRAW_RECT,
+                          rgb_color(rgb_param.num_value),
+                          &rect)) {
+        update_ERRNO_string(_("SDL_Gawk_QueueRect failed"));
+        RETURN_NOK;
+    }
+
+    RETURN_OK;
+}
+
+/* int SDL_Gawk_QueueLine(SDL_Renderer *renderer,
+                          int x1, int y1, int x2, int y2, Uint32 rgb); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_QueueLine --- provide a SDL_Gawk_QueueLine() function for
+                             gawk */
+
+static awk_value_t *
+do_SDL_Gawk_QueueLine(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    awk_value_t x1_param, y1_param, x2_param, y2_param;
+    awk_value_t rgb_param;
+    SDL_Renderer *renderer;
+    SDL_Rect ends;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &x1_param)
+        || ! get_argument(2, AWK_NUMBER, &y1_param)
+        || ! get_argument(3, AWK_NUMBER, &x2_param)
+        || ! get_argument(4, AWK_NUMBER, &y2_param)
+        || ! get_argument(5, AWK_NUMBER, &rgb_param)) {
+        warning(ext_id, _("SDL_Gawk_QueueLine: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
+    ends.x = x1_param.num_value;
+    ends.y = y1_param.num_value;
+    ends.w = x2_param.num_value;
+    ends.h = y2_param.num_value;
+
+    if (! queue_primitive(renderer,
+                          PRIMITIVE_LINE,
+                          rgb_color(rgb_param.num_value),
+                          &ends)) {
+        update_ERRNO_string(_("SDL_Gawk_QueueLine failed"));
+        RETURN_NOK;
+    }
+
+    RETURN_OK;
+}
+
+/* flush_run --- draw a run of queued primitives of one color and kind */
+
+static int
+flush_run(struct renderer_state *state,
+          const struct queued_primitive *run,
+          size_t n)
+{
+    SDL_Renderer *renderer = state->renderer;
+    size_t i;
+    int ret;
+
+    ret = set_draw_color(renderer,
+                         run->color.r, run->color.g, run->color.b,
+                         run->color.a);
+    if (ret < 0)
+        return ret;
+
+    if (run->kind == PRIMITIVE_LINE) {
+        for (i = 0; i < n && ret == 0; i++)
+            ret = SDL_RenderDrawLine(renderer,
+                                     run[i].rect.x, run[i].rect.y,
+                                     run[i].rect.w, run[i].rect.h);
+        state->draw_calls += i;
+        return ret;
+    }
+
+    /* rects of a run go to SDL in a single call */
+    if (flush_rects_capacity < n) {
+        SDL_Rect *rects = gawk_realloc(flush_rects, sizeof(SDL_Rect) * n);
+
+        if (rects == NULL)
+            return -1;
+        flush_rects = rects;
+        flush_rects_capacity = n;
+    }
+    for (i = 0; i < n; i++)
+        flush_rects[i] = run[i].rect;
+
+    state->draw_calls++;
+    return run->kind == PRIMITIVE_FILL_RECT
+               ? SDL_RenderFillRects(renderer, flush_rects, n)
+               : SDL_RenderDrawRects(renderer, flush_rects, n);
+}
+
+/* int SDL_Gawk_FlushQueue(SDL_Renderer *renderer); */
+// /* It doesn't exist in SDL2 */
+/* do_SDL_Gawk_FlushQueue --- provide a SDL_Gawk_FlushQueue() function for
+                              gawk */
+
+static awk_value_t *
+do_SDL_Gawk_FlushQueue(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t renderer_ptr_param;
+    SDL_Renderer *renderer;
+    struct renderer_state *state;
+    SDL_Color color;
+    size_t i, start;
+    size_t runs;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)) {
+        warning(ext_id, _("SDL_Gawk_FlushQueue: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    event_ptr = strtoull(event_ptr_param.str_value.str, (char **)NULL, 16);
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
 
-    if (! event_ptr) {
-        warning(ext_id, _("SDL_Gawk_GetEventType: invalid event"));
+    state = get_renderer_state(renderer);
+    if (state == NULL || state->num_queued == 0)
+        return make_number(0, result);
+
+    if (get_draw_color(renderer, &color.r, &color.g, &color.b, &color.a)
+        < 0) {
+        update_ERRNO_string(_("SDL_Gawk_FlushQueue failed"));
         RETURN_NOK;
     }
 
-    type = ((SDL_Event *)event_ptr)->type;
-    return make_number(type, result);
-}
-
-/* int SDL_PollEvent(SDL_Event *event); */
-/* do_SDL_PollEvent --- provide a SDL_PollEvent() function for gawk */
+    /* grouping by color means one color change and one draw call per
+       run, at the price of the queueing order between colors: queue only
+       what may overlap in any order */
+    qsort(state->queue,
+          state->num_queued,
+          sizeof(struct queued_primitive),
+          compare_primitives);
+
+    ret = 0;
+    runs = 0;
+    for (start = 0, i = 1; ret == 0 && start < state->num_queued; i++) {
+        if (i < state->num_queued
+            && state->queue[i].kind == state->queue[start].kind
+            && memcmp(&state->queue[i].color,
+                      &state->queue[start].color,
+                      sizeof(SDL_Color))
+                   == 0)
+            continue;
+        ret = flush_run(state, &state->queue[start], i - start);
+        runs++;
+        start = i;
+    }
 
-static awk_value_t *
-do_SDL_PollEvent(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
-{
-    awk_value_t event_ptr_param;
-    uintptr_t event_ptr;
+    state->num_queued = 0;
+    state->flushes++;
+    set_draw_color(renderer, color.r, color.g, color.b, color.a);
 
-    if (! get_argument(0, AWK_STRING, &event_ptr_param)) {
-        warning(ext_id, _("SDL_PollEvent: bad parameter(s)"));
+    if (ret < 0) {
+        update_ERRNO_string(_("SDL_Gawk_FlushQueue failed"));
         RETURN_NOK;
     }
 
-    event_ptr = strtoull(event_ptr_param.str_value.str, (char **)NULL, 16);
-
-    return make_number(SDL_PollEvent((SDL_Event *)event_ptr), result);
+    return make_number(runs, result);
 }
 
-/*----- Keyboard Support ---------------------------------------------------*/
+/* set_stat --- store one statistic into an awk array */
 
-/* void SDL_Gawk_GetKeyboardState(int *numkeys, awk_array_t *array); */
+static void
+set_stat(awk_array_t array, const char *name, double num)
+{
+    awk_value_t index, value;
+
+    set_array_element(array,
+                      make_const_string(name, strlen(name), &index),
+                      make_number(num, &value));
+}
+
+/* int SDL_Gawk_RenderStats(SDL_Renderer *renderer, awk_array_t *array,
+                            int reset); */
 // /* It doesn't exist in SDL2 */
-/* do_SDL_Gawk_GetKeyboardState --- provide a SDL_Gawk_GetKeyboardState()
-                                    function for gawk */
+/* do_SDL_Gawk_RenderStats --- provide a SDL_Gawk_RenderStats() function
+                               for gawk */
 
 static awk_value_t *
-do_SDL_Gawk_GetKeyboardState(int nargs,
-                             awk_value_t *result,
-                             struct awk_ext_func *finfo)
+do_SDL_Gawk_RenderStats(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
 {
-    awk_value_t numkeys_ptr_param;
+    awk_value_t renderer_ptr_param;
     awk_value_t array_param;
-    uintptr_t numkeys_ptr;
-    awk_array_t array;
-    const uint8_t *state;
-    awk_value_t index, value;
-    size_t i;
+    awk_value_t reset_param;
+    SDL_Renderer *renderer;
+    struct renderer_state *state;
 
-    if (! get_argument(0, AWK_STRING, &numkeys_ptr_param)
+    if (! get_argument(0, AWK_STRING, &renderer_ptr_param)
         || ! get_argument(1, AWK_ARRAY, &array_param)) {
-        warning(ext_id, _("SDL_Gawk_GetKeyboardState: bad parameter(s)"));
+        warning(ext_id, _("SDL_Gawk_RenderStats: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    numkeys_ptr = strtoull(numkeys_ptr_param.str_value.str,
-                           (char **)NULL,
-                           16);
-    array = array_param.array_cookie;
-
-    state = SDL_GetKeyboardState((int *)numkeys_ptr);
-
-    clear_array(array);
-
-    for (i = 0; i < SDL_NUM_SCANCODES; i++)
-        set_array_element(array,
-                          make_number(i, &index),
-                          make_number(state[i], &value));
-    RETURN_OK;
-}
-
-/*----- Timer Support ------------------------------------------------------*/
-
-/* void SDL_Delay(Uint32 ms); */
-/* do_SDL_Delay --- provide a SDL_Delay() function for gawk */
+    if (nargs > 2) {
+        if (! get_argument(2, AWK_NUMBER, &reset_param)) {
+            warning(ext_id, _("SDL_Gawk_RenderStats: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else {
+        reset_param.num_value = 0;
+    }
 
-static awk_value_t *
-do_SDL_Delay(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
-{
-    awk_value_t ms_param;
-    uint32_t ms;
+    renderer = (SDL_Renderer *)strtoull(renderer_ptr_param.str_value.str,
+                                        (char **)NULL,
+                                        16);
 
-    if (! get_argument(0, AWK_NUMBER, &ms_param)) {
-        warning(ext_id, _("SDL_Delay: bad parameter(s)"));
+    state = get_renderer_state(renderer);
+    if (state == NULL) {
+        update_ERRNO_string(_("SDL_Gawk_RenderStats failed"));
         RETURN_NOK;
     }
 
-    ms = ms_param.num_value;
+    clear_array(array_param.array_cookie);
+    set_stat(array_param.array_cookie, "state_calls", state->state_calls);
+    set_stat(array_param.array_cookie, "state_elided", state->state_elided);
+    set_stat(array_param.array_cookie, "draw_calls", state->draw_calls);
+    set_stat(array_param.array_cookie, "flushes", state->flushes);
+    set_stat(array_param.array_cookie, "queued", state->num_queued);
+
+    if (reset_param.num_value != 0) {
+        state->state_calls = 0;
+        state->state_elided = 0;
+        state->draw_calls = 0;
+        state->flushes = 0;
+    }
 
-    SDL_Delay(ms);
     RETURN_OK;
 }
 
-/* Uint32 SDL_GetTicks(void); */
-/* do_SDL_GetTicks --- provide a SDL_GetTicks() function for gawk */
+/* forget_renderer --- drop the extension's state for a renderer that is
+                       being destroyed, along with the textures that SDL
+                       frees with it */
 
-static awk_value_t *
-do_SDL_GetTicks(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+static void
+forget_renderer(SDL_Renderer *renderer)
 {
-    uint32_t ms = SDL_GetTicks();
-    return make_number(ms, result);
-}
+    struct glyph_atlas **atlas;
+    struct console **console;
+    struct render_layer **layer;
+    struct renderer_state **state;
+
+    for (atlas = &glyph_atlases; *atlas != NULL;) {
+        struct glyph_atlas *dead = *atlas;
+
+        if (dead->renderer != renderer) {
+            atlas = &dead->next;
+            continue;
+        }
+        *atlas = dead->next;
+        gawk_free(dead);
+    }
 
-/*----- Message boxes ------------------------------------------------------*/
+    for (console = &consoles; *console != NULL;) {
+        struct console *dead = *console;
 
-/* int SDL_ShowSimpleMessageBox(Uint32 flags,
-                                const char *title,
-                                const char *message,
-                                SDL_Window *window); */
-/* do_SDL_ShowSimpleMessageBox --- provide a SDL_ShowSimpleMessageBox()
-                                   function for gawk */
+        if (dead->renderer != renderer) {
+            console = &dead->next;
+            continue;
+        }
+        *console = dead->next;
+        gawk_free(dead->cells);
+        gawk_free(dead);
+    }
 
-static awk_value_t *
-do_SDL_ShowSimpleMessageBox(int nargs,
-                            awk_value_t *result,
-                            struct awk_ext_func *finfo)
-{
-    awk_value_t flags_param;
-    awk_value_t title_param;
-    awk_value_t message_param;
-    awk_value_t window_ptr_param;
-    uint32_t flags;
-    const char *title;
-    const char *message;
-    uintptr_t window_ptr;
-    int ret;
+    for (layer = &render_layers; *layer != NULL;) {
+        struct render_layer *dead = *layer;
 
-    if (! get_argument(0, AWK_NUMBER, &flags_param)
-        || ! get_argument(1, AWK_STRING, &title_param)
-        || ! get_argument(2, AWK_STRING, &message_param)
-        || ! get_argument(3, AWK_STRING, &window_ptr_param)) {
-        warning(ext_id, _("SDL_ShowSimpleMessageBox: bad parameter(s)"));
-        RETURN_NOK;
+        if (dead->renderer != renderer) {
+            layer = &dead->next;
+            continue;
+        }
+        *layer = dead->next;
+        gawk_free(dead);
     }
 
-    flags = flags_param.num_value;
-    title = title_param.str_value.str;
-    message = message_param.str_value.str;
-    window_ptr = strtoull(window_ptr_param.str_value.str, (char **)NULL, 16);
-
-    ret = SDL_ShowSimpleMessageBox(flags,
-                                   title,
-                                   message,
-                                   (SDL_Window *)window_ptr);
-    if (ret < 0)
-        update_ERRNO_string(_("SDL_ShowSimpleMessageBox failed"));
+    for (state = &renderer_states; *state != NULL;) {
+        struct renderer_state *dead = *state;
 
-    return make_number(ret, result);
+        if (dead->renderer != renderer) {
+            state = &dead->next;
+            continue;
+        }
+        *state = dead->next;
+        gawk_free(dead->queue);
+        gawk_free(dead);
+    }
 }
 
 /*--------------------------------------------------------------------------*/
@@ -2994,6 +9334,8 @@ static awk_bool_t
 init_sdl2(void)
 {
     load_vars();
+    pool_init(&rect_pool, sizeof(SDL_Rect));
+    pool_init(&event_pool, sizeof(SDL_Event));
     return awk_true;
 }
 
@@ -3026,11 +9368,23 @@ static awk_ext_func_t func_table[] = {
     { "SDL_RenderDrawLine", do_SDL_RenderDrawLine, 5, 5, awk_false, NULL },
     { "SDL_RenderDrawRect", do_SDL_RenderDrawRect, 2, 2, awk_false, NULL },
     { "SDL_RenderFillRect", do_SDL_RenderFillRect, 2, 2, awk_false, NULL },
+    { "SDL_RenderDrawRects", do_SDL_RenderDrawRects, 3, 3, awk_false, NULL },
+    { "SDL_RenderFillRects", do_SDL_RenderFillRects, 3, 3, awk_false, NULL },
     { "SDL_RenderPresent", do_SDL_RenderPresent, 1, 1, awk_false, NULL },
     { "SDL_SetRenderDrawColor", do_SDL_SetRenderDrawColor,
       5, 5,
       awk_false,
       NULL },
+    { "SDL_SetRenderDrawBlendMode", do_SDL_SetRenderDrawBlendMode,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_GetRenderDrawBlendMode", do_SDL_GetRenderDrawBlendMode,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_SetRenderTarget", do_SDL_SetRenderTarget, 2, 2, awk_false, NULL },
+    { "SDL_GetRenderTarget", do_SDL_GetRenderTarget, 1, 1, awk_false, NULL },
     { "SDL_CreateTexture", do_SDL_CreateTexture, 5, 5, awk_false, NULL },
     { "SDL_CreateTextureFromSurface", do_SDL_CreateTextureFromSurface,
       2, 2,
@@ -3042,10 +9396,18 @@ static awk_ext_func_t func_table[] = {
       1, 1,
       awk_false,
       NULL },
+    { "SDL_Gawk_FreeColorPalette", do_SDL_Gawk_FreeColorPalette,
+      1, 1,
+      awk_false,
+      NULL },
     { "SDL_Gawk_UpdateColorPalette", do_SDL_Gawk_UpdateColorPalette,
       6, 6,
       awk_false,
       NULL },
+    { "SDL_Gawk_LoadColorPalette", do_SDL_Gawk_LoadColorPalette,
+      3, 2,
+      awk_false,
+      NULL },
     { "SDL_AllocPalette", do_SDL_AllocPalette, 1, 1, awk_false, NULL },
     { "SDL_FreePalette", do_SDL_FreePalette, 1, 1, awk_false, NULL },
     { "SDL_SetPaletteColors", do_SDL_SetPaletteColors,
@@ -3072,8 +9434,34 @@ static awk_ext_func_t func_table[] = {
       NULL },
     { "SDL_MapRGBA", do_SDL_MapRGBA, 5, 5, awk_false, NULL },
     { "SDL_Gawk_AllocRect", do_SDL_Gawk_AllocRect, 0, 0, awk_false, NULL },
+    { "SDL_Gawk_FreeRect", do_SDL_Gawk_FreeRect, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_ArenaAllocRect", do_SDL_Gawk_ArenaAllocRect,
+      0, 0,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ArenaReset", do_SDL_Gawk_ArenaReset, 0, 0, awk_false, NULL },
+    { "SDL_Gawk_AllocRects", do_SDL_Gawk_AllocRects, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_SetRects", do_SDL_Gawk_SetRects, 3, 2, awk_false, NULL },
+    { "SDL_Gawk_RectAt", do_SDL_Gawk_RectAt, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_FreeRects", do_SDL_Gawk_FreeRects, 1, 1, awk_false, NULL },
     { "SDL_Gawk_UpdateRect", do_SDL_Gawk_UpdateRect, 5, 5, awk_false, NULL },
     { "SDL_HasIntersection", do_SDL_HasIntersection, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_CreateCollisionWorld", do_SDL_Gawk_CreateCollisionWorld,
+      0, 0,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_CollidePairs", do_SDL_Gawk_CollidePairs,
+      4, 4,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_CollideRect", do_SDL_Gawk_CollideRect,
+      5, 5,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DestroyCollisionWorld", do_SDL_Gawk_DestroyCollisionWorld,
+      1, 1,
+      awk_false,
+      NULL },
     { "SDL_BlitSurface", do_SDL_BlitSurface, 4, 4, awk_false, NULL },
     { "SDL_CreateRGBSurface", do_SDL_CreateRGBSurface,
       8, 8,
@@ -3102,6 +9490,7 @@ static awk_ext_func_t func_table[] = {
       NULL },
     { "SDL_FillRect", do_SDL_FillRect, 3, 3, awk_false, NULL },
     { "SDL_Gawk_AllocEvent", do_SDL_Gawk_AllocEvent, 0, 0, awk_false, NULL },
+    { "SDL_Gawk_FreeEvent", do_SDL_Gawk_FreeEvent, 1, 1, awk_false, NULL },
     { "SDL_Gawk_GetEventType", do_SDL_Gawk_GetEventType,
       1, 1,
       awk_false,
@@ -3117,6 +9506,173 @@ static awk_ext_func_t func_table[] = {
       4, 4,
       awk_false,
       NULL },
+    { "SDL_Gawk_CreateBuffer", do_SDL_Gawk_CreateBuffer,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DestroyBuffer", do_SDL_Gawk_DestroyBuffer,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_BufferLength", do_SDL_Gawk_BufferLength,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ResizeBuffer", do_SDL_Gawk_ResizeBuffer,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_BufferGet", do_SDL_Gawk_BufferGet, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_BufferSet", do_SDL_Gawk_BufferSet, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_BufferImport", do_SDL_Gawk_BufferImport,
+      3, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_BufferExport", do_SDL_Gawk_BufferExport,
+      4, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_BufferFill", do_SDL_Gawk_BufferFill, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_BufferScale", do_SDL_Gawk_BufferScale, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_BufferClamp", do_SDL_Gawk_BufferClamp, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_BufferAdd", do_SDL_Gawk_BufferAdd, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_BufferAxpy", do_SDL_Gawk_BufferAxpy, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_BufferData", do_SDL_Gawk_BufferData, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_Integrate", do_SDL_Gawk_Integrate, 10, 5, awk_false, NULL },
+    { "SDL_Gawk_BuffersToRects", do_SDL_Gawk_BuffersToRects,
+      5, 5,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_CreateParticleSystem", do_SDL_Gawk_CreateParticleSystem,
+      2, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_SetParticleParam", do_SDL_Gawk_SetParticleParam,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_SetParticleRamp", do_SDL_Gawk_SetParticleRamp,
+      4, 4,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_AddParticleEmitter", do_SDL_Gawk_AddParticleEmitter,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_SetParticleEmitter", do_SDL_Gawk_SetParticleEmitter,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_BurstParticles", do_SDL_Gawk_BurstParticles,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_UpdateParticles", do_SDL_Gawk_UpdateParticles,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_RenderParticles", do_SDL_Gawk_RenderParticles,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DestroyParticleSystem", do_SDL_Gawk_DestroyParticleSystem,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DrawText", do_SDL_Gawk_DrawText, 5, 4, awk_false, NULL },
+    { "SDL_Gawk_CreateConsole", do_SDL_Gawk_CreateConsole,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ConsoleColor", do_SDL_Gawk_ConsoleColor,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ConsoleMoveCursor", do_SDL_Gawk_ConsoleMoveCursor,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ConsoleWrite", do_SDL_Gawk_ConsoleWrite,
+      2, 2,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ConsoleClear", do_SDL_Gawk_ConsoleClear,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_RenderConsole", do_SDL_Gawk_RenderConsole,
+      4, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DestroyConsole", do_SDL_Gawk_DestroyConsole,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_CreatePlot", do_SDL_Gawk_CreatePlot, 2, 2, awk_false, NULL },
+    { "SDL_Gawk_SetPlotRange", do_SDL_Gawk_SetPlotRange,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_SetPlotColor", do_SDL_Gawk_SetPlotColor,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_PlotPush", do_SDL_Gawk_PlotPush, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_PlotPushArray", do_SDL_Gawk_PlotPushArray,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_PlotPushBuffer", do_SDL_Gawk_PlotPushBuffer,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ClearPlot", do_SDL_Gawk_ClearPlot, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_RenderPlot", do_SDL_Gawk_RenderPlot, 6, 6, awk_false, NULL },
+    { "SDL_Gawk_DestroyPlot", do_SDL_Gawk_DestroyPlot, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_Heatmap", do_SDL_Gawk_Heatmap, 7, 7, awk_false, NULL },
+    { "SDL_Gawk_CreateDensityGrid", do_SDL_Gawk_CreateDensityGrid,
+      6, 6,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DensityAdd", do_SDL_Gawk_DensityAdd, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_DensityAddBuffers", do_SDL_Gawk_DensityAddBuffers,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_ClearDensityGrid", do_SDL_Gawk_ClearDensityGrid,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_RenderDensity", do_SDL_Gawk_RenderDensity,
+      3, 3,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DestroyDensityGrid", do_SDL_Gawk_DestroyDensityGrid,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_DownsampleLTTB", do_SDL_Gawk_DownsampleLTTB,
+      7, 7,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_RenderLTTB", do_SDL_Gawk_RenderLTTB, 9, 9, awk_false, NULL },
+    { "SDL_Gawk_MapColumns", do_SDL_Gawk_MapColumns, 6, 4, awk_false, NULL },
+    { "SDL_Gawk_CreateLayer", do_SDL_Gawk_CreateLayer, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_BeginLayer", do_SDL_Gawk_BeginLayer, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_EndLayer", do_SDL_Gawk_EndLayer, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_InvalidateLayer", do_SDL_Gawk_InvalidateLayer,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_RenderLayer", do_SDL_Gawk_RenderLayer, 3, 3, awk_false, NULL },
+    { "SDL_Gawk_DestroyLayer", do_SDL_Gawk_DestroyLayer,
+      1, 1,
+      awk_false,
+      NULL },
+    { "SDL_Gawk_QueueRect", do_SDL_Gawk_QueueRect, 7, 6, awk_false, NULL },
+    { "SDL_Gawk_QueueLine", do_SDL_Gawk_QueueLine, 6, 6, awk_false, NULL },
+    { "SDL_Gawk_FlushQueue", do_SDL_Gawk_FlushQueue, 1, 1, awk_false, NULL },
+    { "SDL_Gawk_RenderStats", do_SDL_Gawk_RenderStats, 3, 2, awk_false, NULL },
 };
 
 /* define the dl_load() function using the boilerplate macro */
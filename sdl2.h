@@ -78,6 +78,11 @@
 #define DEFAULT_SDL_TEXTUREACCESS_STATIC SDL_TEXTUREACCESS_STATIC
 #define DEFAULT_SDL_TEXTUREACCESS_STREAMING SDL_TEXTUREACCESS_STREAMING
 #define DEFAULT_SDL_TEXTUREACCESS_TARGET SDL_TEXTUREACCESS_TARGET
+#define DEFAULT_SDL_BLENDMODE_NONE SDL_BLENDMODE_NONE
+#define DEFAULT_SDL_BLENDMODE_BLEND SDL_BLENDMODE_BLEND
+#define DEFAULT_SDL_BLENDMODE_ADD SDL_BLENDMODE_ADD
+#define DEFAULT_SDL_BLENDMODE_MOD SDL_BLENDMODE_MOD
+#define DEFAULT_SDL_BLENDMODE_MUL SDL_BLENDMODE_MUL
 
 /* Pixel Formats and Conversion Routines */
 #define DEFAULT_SDL_PIXELFORMAT_UNKNOWN SDL_PIXELFORMAT_UNKNOWN
@@ -6,6 +6,9 @@
 #endif
 
 #include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -29,6 +32,8 @@ static awk_ext_id_t ext_id;
 static awk_bool_t init_sdl2_mixer(void);
 static awk_bool_t (*init_func)(void) = init_sdl2_mixer;
 static const char *ext_version = "SDL2_mixer extension: version (untracked)";
+static void end_offline(void);
+static void free_music_loads(void);
 
 awk_bool_t gawk_api_varinit_constant(const gawk_api_t *,
                                      awk_ext_id_t,
@@ -181,7 +186,9 @@ do_Mix_OpenAudio(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 static awk_value_t *
 do_Mix_CloseAudio(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 {
+    free_music_loads();
     Mix_CloseAudio();
+    end_offline();
     RETURN_OK;
 }
 
@@ -285,8 +292,447 @@ do_Mix_FreeChunk(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
     RETURN_OK;
 }
 
+/* write_sample --- store a sample in [-1.0, 1.0] using the audio format */
+
+static void
+write_sample(uint8_t *dst, float sample, uint16_t format)
+{
+    uint32_t bits;
+    int bytes;
+    int i;
+
+    if (sample > 1.0f)
+        sample = 1.0f;
+    if (sample < -1.0f)
+        sample = -1.0f;
+
+    if (SDL_AUDIO_ISFLOAT(format)) {
+        memcpy(&bits, &sample, sizeof(bits));
+    } else {
+        switch (SDL_AUDIO_BITSIZE(format)) {
+        case 8:
+            bits = (uint8_t)(int8_t)(sample * 127.0f);
+            break;
+        case 16:
+            bits = (uint16_t)(int16_t)(sample * 32767.0f);
+            break;
+        default:
+            bits = (uint32_t)(int32_t)((double)sample * 2147483647.0);
+            break;
+        }
+        if (! SDL_AUDIO_ISSIGNED(format))
+            bits ^= 1U << (SDL_AUDIO_BITSIZE(format) - 1);
+    }
+
+    bytes = SDL_AUDIO_BITSIZE(format) / 8;
+    for (i = 0; i < bytes; i++) {
+        int shift = SDL_AUDIO_ISBIGENDIAN(format) ? (bytes - 1 - i) * 8
+                                                  : i * 8;
+        dst[i] = (bits >> shift) & 0xFF;
+    }
+}
+
+/* read_sample --- load a sample in the audio format as [-1.0, 1.0] */
+
+static float
+read_sample(const uint8_t *src, uint16_t format)
+{
+    uint32_t bits;
+    int bytes;
+    int i;
+    float sample;
+
+    bits = 0;
+    bytes = SDL_AUDIO_BITSIZE(format) / 8;
+    for (i = 0; i < bytes; i++) {
+        int shift = SDL_AUDIO_ISBIGENDIAN(format) ? (bytes - 1 - i) * 8
+                                                  : i * 8;
+        bits |= (uint32_t)src[i] << shift;
+    }
+
+    if (SDL_AUDIO_ISFLOAT(format)) {
+        memcpy(&sample, &bits, sizeof(sample));
+        return sample;
+    }
+
+    if (! SDL_AUDIO_ISSIGNED(format))
+        bits ^= 1U << (SDL_AUDIO_BITSIZE(format) - 1);
+
+    switch (SDL_AUDIO_BITSIZE(format)) {
+    case 8:
+        return (int8_t)bits / 128.0f;
+    case 16:
+        return (int16_t)bits / 32768.0f;
+    default:
+        return (float)((int32_t)bits / 2147483648.0);
+    }
+}
+
+/* get_spec_number --- fetch a numeric element from a spec array */
+
+static double
+get_spec_number(awk_array_t spec, const char *name, double dfltval)
+{
+    awk_value_t index, value;
+
+    if (get_array_element(spec,
+                          make_const_string(name, strlen(name), &index),
+                          AWK_NUMBER,
+                          &value))
+        return value.num_value;
+
+    return dfltval;
+}
+
+/* next_noise --- return the next xorshift32 noise sample in [-1.0, 1.0] */
+
+static float
+next_noise(uint32_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return (*seed & 0xFFFF) / 32767.5f - 1.0f;
+}
+
+enum synth_wave {
+    SYNTH_SQUARE,
+    SYNTH_SINE,
+    SYNTH_SAWTOOTH,
+    SYNTH_TRIANGLE,
+    SYNTH_NOISE,
+};
+
+#define MAX_SYNTH_DURATION 60000  /* ms */
+
+/* Mix_Chunk *Mix_Gawk_Synthesize(awk_array_t *spec); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_Synthesize --- provide a Mix_Gawk_Synthesize()
+                              function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_Synthesize(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    Mix_Chunk *chunk;
+    awk_value_t spec_param;
+    awk_array_t spec;
+    awk_value_t index, value;
+    enum synth_wave wave;
+    double frequency, frequency_end;
+    double duty;
+    double volume;
+    double duration, attack, decay, sustain, release;
+    double seed_num;
+    uint32_t seed;
+    int freq;
+    uint16_t format;
+    int channels;
+    int frame_size;
+    uint32_t frames, attack_frames, decay_frames, release_frames;
+    uint32_t release_start;
+    uint8_t *abuf;
+    double phase, prev_phase;
+    double f, step;
+    float noise;
+    uint32_t i;
+    int c;
+
+    if (! get_argument(0, AWK_ARRAY, &spec_param)) {
+        warning(ext_id, _("Mix_Gawk_Synthesize: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    spec = spec_param.array_cookie;
+
+    wave = SYNTH_SQUARE;
+    if (get_array_element(spec,
+                          make_const_string("wave", 4, &index),
+                          AWK_STRING,
+                          &value)) {
+        const char *name = value.str_value.str;
+
+        if (strcmp(name, "square") == 0)
+            wave = SYNTH_SQUARE;
+        else if (strcmp(name, "sine") == 0)
+            wave = SYNTH_SINE;
+        else if (strcmp(name, "sawtooth") == 0 || strcmp(name, "saw") == 0)
+            wave = SYNTH_SAWTOOTH;
+        else if (strcmp(name, "triangle") == 0)
+            wave = SYNTH_TRIANGLE;
+        else if (strcmp(name, "noise") == 0)
+            wave = SYNTH_NOISE;
+        else {
+            warning(ext_id,
+                    _("Mix_Gawk_Synthesize: unknown wave `%s'"),
+                    name);
+            RETURN_NOK;
+        }
+    }
+
+    frequency = get_spec_number(spec, "frequency", 440);
+    frequency_end = get_spec_number(spec, "frequency_end", frequency);
+    duty = get_spec_number(spec, "duty", 0.5);
+    volume = get_spec_number(spec, "volume", MIX_MAX_VOLUME) / MIX_MAX_VOLUME;
+    duration = get_spec_number(spec, "duration", 200);
+    attack = get_spec_number(spec, "attack", 0);
+    decay = get_spec_number(spec, "decay", 0);
+    sustain = get_spec_number(spec, "sustain", 1);
+    release = get_spec_number(spec, "release", 0);
+    seed_num = get_spec_number(spec, "seed", 1);
+
+    /* written so that NaN fails every test */
+    if (! (frequency > 0 && isfinite(frequency))
+        || ! (frequency_end > 0 && isfinite(frequency_end))
+        || ! (duration > 0 && duration <= MAX_SYNTH_DURATION)
+        || ! (attack >= 0 && decay >= 0 && release >= 0)
+        || ! (sustain >= 0 && sustain <= 1)
+        || ! (seed_num >= 0 && seed_num <= UINT32_MAX)
+        || ! isfinite(duty) || ! isfinite(volume)) {
+        warning(ext_id, _("Mix_Gawk_Synthesize: invalid spec"));
+        RETURN_NOK;
+    }
+    seed = seed_num;
+
+    if (! Mix_QuerySpec(&freq, &format, &channels)) {
+        update_ERRNO_string(_("Mix_Gawk_Synthesize failed"));
+        return make_null_string(result);
+    }
+
+    frame_size = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    frames = duration * freq / 1000;
+    attack_frames = SDL_min(attack * freq / 1000, frames);
+    decay_frames = SDL_min(decay * freq / 1000, frames - attack_frames);
+    release_frames = SDL_min(release * freq / 1000,
+                             frames - attack_frames - decay_frames);
+    release_start = frames - release_frames;
+
+    if (frames == 0 || (uint64_t)frames * frame_size > UINT32_MAX
+        || (abuf = SDL_malloc(frames * frame_size)) == NULL) {
+        update_ERRNO_string(_("Mix_Gawk_Synthesize failed"));
+        return make_null_string(result);
+    }
+
+    if (duty <= 0 || duty >= 1)
+        duty = 0.5;
+    if (seed == 0)
+        seed = 1;
+
+    /* sweeps are exponential, so the pitch changes at a constant rate */
+    f = frequency;
+    step = pow(frequency_end / frequency, 1.0 / frames);
+    phase = 0;
+    noise = next_noise(&seed);
+    for (i = 0; i < frames; i++) {
+        double envelope;
+        float sample;
+
+        switch (wave) {
+        case SYNTH_SQUARE:
+            sample = phase < duty ? 1.0f : -1.0f;
+            break;
+        case SYNTH_SINE:
+            sample = sin(2 * M_PI * phase);
+            break;
+        case SYNTH_SAWTOOTH:
+            sample = 2 * phase - 1;
+            break;
+        case SYNTH_TRIANGLE:
+            sample = phase < 0.5 ? 4 * phase - 1 : 3 - 4 * phase;
+            break;
+        case SYNTH_NOISE:
+        default:
+            sample = noise;
+            break;
+        }
+
+        if (i < attack_frames)
+            envelope = (double)i / attack_frames;
+        else if (i < attack_frames + decay_frames)
+            envelope = 1 - (1 - sustain) * (i - attack_frames) / decay_frames;
+        else
+            envelope = sustain;
+        if (i >= release_start)
+            envelope *= (double)(frames - i) / release_frames;
+
+        sample *= envelope * volume;
+        for (c = 0; c < channels; c++)
+            write_sample(abuf + (size_t)i * frame_size
+                         + c * (frame_size / channels),
+                         sample,
+                         format);
+
+        /* noise is resampled every half period, which gives it a pitch */
+        prev_phase = phase;
+        phase += f / freq;
+        phase -= (int)phase;
+        if ((phase < 0.5) != (prev_phase < 0.5))
+            noise = next_noise(&seed);
+        f *= step;
+    }
+
+    chunk = Mix_QuickLoad_RAW(abuf, frames * frame_size);
+
+    if (chunk) {
+        char chunk_addr[20];
+        /* let Mix_FreeChunk() release abuf as well */
+        chunk->allocated = 1;
+        // NOLINTNEXTLINE
+        snprintf(chunk_addr, sizeof(chunk_addr), "%p", chunk);
+        return make_string_malloc(chunk_addr, strlen(chunk_addr), result);
+    }
+
+    SDL_free(abuf);
+    update_ERRNO_string(_("Mix_Gawk_Synthesize failed"));
+    return make_null_string(result);
+}
+
 /*----- Handle Channels for Sound Effects ----------------------------------*/
 
+/* per-channel bookkeeping for the Mix_Gawk_* channel functions */
+struct channel_state {
+    Mix_Chunk *chunk;     /* chunk started by Mix_Gawk_PlayVoice() */
+    int priority;         /* higher values are stolen last */
+    uint64_t serial;      /* start order, lower values are older */
+    awk_bool_t emitter;   /* positioned by Mix_Gawk_UpdateListener() */
+    double x, y;
+    int angle;            /* last Mix_SetPosition() values, -1 for none */
+    int distance;
+    int pan;              /* last Mix_SetPanning() values, -1 for none */
+    int generation;       /* of the cached angle or pan */
+    int tag;              /* group set by Mix_GroupChannel(s)() */
+};
+
+static struct channel_state *channel_states;
+static int num_channel_states;
+static uint64_t voice_serial;
+static int reserved_channels; /* kept out of Mix_Gawk_PlayVoice()'s reach */
+
+#define MAX_TRACKED_CHANNELS 256
+
+/* counters reported by Mix_Gawk_Stats(), updated by the audio callback
+   while enabled (the voice counters are always kept) */
+static struct mixer_stats {
+    awk_bool_t enabled;
+    int freq;
+    int frame_size;
+    uint64_t callbacks;
+    uint64_t frames;
+    uint64_t last_counter;
+    double interval_sum;
+    double interval_max;
+    uint64_t late;
+    double dsp_sum;
+    double dsp_max;
+    double dsp_current;       /* DSP time spent in the current callback */
+    uint64_t active_sum;
+    uint64_t active[MAX_TRACKED_CHANNELS];
+    uint64_t voices_played;
+    uint64_t voices_stolen;
+    uint64_t voices_dropped;
+} mixer_stats;
+
+/* dsp_begin --- start timing extension DSP inside the audio callback */
+
+static uint64_t
+dsp_begin(void)
+{
+    return mixer_stats.enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+/* dsp_end --- charge the time since dsp_begin() to the current callback */
+
+static void
+dsp_end(uint64_t start)
+{
+    if (start != 0)
+        mixer_stats.dsp_current += (double)(SDL_GetPerformanceCounter()
+                                            - start)
+                                   / SDL_GetPerformanceFrequency();
+}
+
+/* bumped whenever a channel stops, since SDL_mixer then drops its
+   effects, panning and position included */
+static SDL_atomic_t channel_generations[MAX_TRACKED_CHANNELS];
+static awk_bool_t channel_finished_installed;
+
+/* channel_finished --- note that a channel lost its effects */
+
+static void
+channel_finished(int channel)
+{
+    if (channel < MAX_TRACKED_CHANNELS)
+        SDL_AtomicAdd(&channel_generations[channel], 1);
+}
+
+/* channel_generation --- return the effect generation of a channel,
+                          or -1 if it is not tracked */
+
+static int
+channel_generation(int channel)
+{
+    /* SDL_mixer has a single slot for this callback, and the extension
+       does not bind Mix_ChannelFinished() otherwise */
+    if (! channel_finished_installed) {
+        Mix_ChannelFinished(channel_finished);
+        channel_finished_installed = awk_true;
+    }
+
+    if (channel >= MAX_TRACKED_CHANNELS)
+        return -1;
+    return SDL_AtomicGet(&channel_generations[channel]);
+}
+
+/* ensure_channel_states --- make room for numchans channel states */
+
+static awk_bool_t
+ensure_channel_states(int numchans)
+{
+    struct channel_state *states;
+    int i;
+
+    if (numchans <= num_channel_states)
+        return awk_true;
+
+    states = gawk_realloc(channel_states, numchans * sizeof(*states));
+    if (states == NULL)
+        return awk_false;
+
+    memset(states + num_channel_states,
+           0,
+           (numchans - num_channel_states) * sizeof(*states));
+    for (i = num_channel_states; i < numchans; i++) {
+        states[i].angle = -1;
+        states[i].pan = -1;
+        states[i].tag = -1;
+    }
+    channel_states = states;
+    num_channel_states = numchans;
+    return awk_true;
+}
+
+/* forget_position --- drop the cached position and panning of a channel */
+
+static void
+forget_position(int channel)
+{
+    if (channel >= 0 && channel < num_channel_states) {
+        channel_states[channel].angle = -1;
+        channel_states[channel].pan = -1;
+    }
+}
+
+/* is_voice --- tell whether a playing channel was started as a voice */
+
+static awk_bool_t
+is_voice(int channel)
+{
+    /* channels played directly with Mix_PlayChannel() are never stolen */
+    return channel_states[channel].chunk != NULL
+           && Mix_GetChunk(channel) == channel_states[channel].chunk;
+}
+
 /* int Mix_AllocateChannels(int numchans); */
 /* do_Mix_AllocateChannels --- provide a Mix_AllocateChannels()
                                function for gawk */
@@ -298,6 +744,7 @@ do_Mix_AllocateChannels(int nargs,
 {
     awk_value_t numchans_param;
     int numchans;
+    int ret;
 
     if (! get_argument(0, AWK_NUMBER, &numchans_param)) {
         warning(ext_id, _("Mix_AllocateChannels: bad parameter(s)"));
@@ -306,7 +753,11 @@ do_Mix_AllocateChannels(int nargs,
 
     numchans = numchans_param.num_value;
 
-    return make_number(Mix_AllocateChannels(numchans), result);
+    ret = Mix_AllocateChannels(numchans);
+    if (! ensure_channel_states(ret))
+        update_ERRNO_string(_("Mix_AllocateChannels failed"));
+
+    return make_number(ret, result);
 }
 
 /* int Mix_PlayChannelTimed(int channel,
@@ -358,6 +809,64 @@ do_Mix_PlayChannelTimed(int nargs,
     return make_number(ret, result);
 }
 
+/* int Mix_FadeInChannelTimed(int channel,
+                              Mix_Chunk *chunk,
+                              int loops,
+                              int ms,
+                              int ticks); */
+/* do_Mix_FadeInChannelTimed --- provide a Mix_FadeInChannelTimed()
+                                 function for gawk */
+
+static awk_value_t *
+do_Mix_FadeInChannelTimed(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t chunk_ptr_param;
+    awk_value_t loops_param;
+    awk_value_t ms_param;
+    awk_value_t ticks_param;
+    int channel;
+    uintptr_t chunk_ptr;
+    int loops;
+    int ms;
+    int ticks;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_STRING, &chunk_ptr_param)
+        || ! get_argument(2, AWK_NUMBER, &loops_param)
+        || ! get_argument(3, AWK_NUMBER, &ms_param)) {
+        warning(ext_id, _("Mix_FadeInChannelTimed: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 4) {
+        if (! get_argument(4, AWK_NUMBER, &ticks_param)) {
+            warning(ext_id, _("Mix_FadeInChannelTimed: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else
+        ticks_param.num_value = -1;
+
+    channel = channel_param.num_value;
+    chunk_ptr = strtoull(chunk_ptr_param.str_value.str, (char **)NULL, 16);
+    loops = loops_param.num_value;
+    ms = ms_param.num_value;
+    ticks = ticks_param.num_value;
+
+    ret = Mix_FadeInChannelTimed(channel,
+                                 (Mix_Chunk *)chunk_ptr,
+                                 loops,
+                                 ms,
+                                 ticks);
+    if (ret < 0)
+        update_ERRNO_string(_("Mix_FadeInChannelTimed failed"));
+
+    return make_number(ret, result);
+}
+
 /* int Mix_HaltChannel(int channel); */
 /* do_Mix_HaltChannel --- provide a Mix_HaltChannel() function for gawk */
 
@@ -382,116 +891,579 @@ do_Mix_HaltChannel(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
     return make_number(ret, result);
 }
 
-/* int Mix_Playing(int channel); */
-/* do_Mix_Playing --- provide a Mix_Playing() function for gawk */
+/* int Mix_Volume(int channel, int volume); */
+/* do_Mix_Volume --- provide a Mix_Volume() function for gawk */
 
 static awk_value_t *
-do_Mix_Playing(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+do_Mix_Volume(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 {
     awk_value_t channel_param;
+    awk_value_t volume_param;
     int channel;
+    int volume;
 
-    if (! get_argument(0, AWK_NUMBER, &channel_param)) {
-        warning(ext_id, _("Mix_Playing: bad parameter(s)"));
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &volume_param)) {
+        warning(ext_id, _("Mix_Volume: bad parameter(s)"));
         RETURN_NOK;
     }
 
     channel = channel_param.num_value;
+    volume = volume_param.num_value;
 
-    return make_number(Mix_Playing(channel), result);
+    return make_number(Mix_Volume(channel, volume), result);
 }
 
-/*----- Play Music ---------------------------------------------------------*/
-
-/* Mix_Music *Mix_LoadMUS(const char *file); */
-/* do_Mix_LoadMUS --- provide a Mix_LoadMUS() function for gawk */
+/* int Mix_ExpireChannel(int channel, int ticks); */
+/* do_Mix_ExpireChannel --- provide a Mix_ExpireChannel()
+                            function for gawk */
 
 static awk_value_t *
-do_Mix_LoadMUS(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+do_Mix_ExpireChannel(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
 {
-    Mix_Music *music;
-    awk_value_t file_param;
-    const char *file;
+    awk_value_t channel_param;
+    awk_value_t ticks_param;
+    int channel;
+    int ticks;
 
-    if (! get_argument(0, AWK_STRING, &file_param)) {
-        warning(ext_id, _("Mix_LoadMUS: bad parameter(s)"));
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &ticks_param)) {
+        warning(ext_id, _("Mix_ExpireChannel: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    file = file_param.str_value.str;
+    channel = channel_param.num_value;
+    ticks = ticks_param.num_value;
 
-    music = Mix_LoadMUS(file);
+    return make_number(Mix_ExpireChannel(channel, ticks), result);
+}
 
-    if (music) {
-        char music_addr[20];
-        // NOLINTNEXTLINE
-        snprintf(music_addr, sizeof(music_addr), "%p", music);
-        return make_string_malloc(music_addr, strlen(music_addr), result);
+/* int Mix_FadeOutChannel(int which, int ms); */
+/* do_Mix_FadeOutChannel --- provide a Mix_FadeOutChannel()
+                             function for gawk */
+
+static awk_value_t *
+do_Mix_FadeOutChannel(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t which_param;
+    awk_value_t ms_param;
+    int which;
+    int ms;
+
+    if (! get_argument(0, AWK_NUMBER, &which_param)
+        || ! get_argument(1, AWK_NUMBER, &ms_param)) {
+        warning(ext_id, _("Mix_FadeOutChannel: bad parameter(s)"));
+        RETURN_NOK;
     }
 
-    update_ERRNO_string(_("Mix_LoadMUS failed"));
-    return make_null_string(result);
+    which = which_param.num_value;
+    ms = ms_param.num_value;
+
+    return make_number(Mix_FadeOutChannel(which, ms), result);
 }
 
-/* void Mix_FreeMusic(Mix_Music *music); */
-/* do_Mix_FreeMusic --- provide a Mix_FreeMusic() function for gawk */
+/* int Mix_Playing(int channel); */
+/* do_Mix_Playing --- provide a Mix_Playing() function for gawk */
 
 static awk_value_t *
-do_Mix_FreeMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+do_Mix_Playing(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 {
-    awk_value_t music_ptr_param;
-    uintptr_t music_ptr;
+    awk_value_t channel_param;
+    int channel;
 
-    if (! get_argument(0, AWK_STRING, &music_ptr_param)) {
-        warning(ext_id, _("Mix_FreeMusic: bad parameter(s)"));
+    if (! get_argument(0, AWK_NUMBER, &channel_param)) {
+        warning(ext_id, _("Mix_Playing: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    music_ptr = strtoull(music_ptr_param.str_value.str, (char **)NULL, 16);
+    channel = channel_param.num_value;
 
-    Mix_FreeMusic((Mix_Music *)music_ptr);
-    RETURN_OK;
+    return make_number(Mix_Playing(channel), result);
 }
 
-/* int Mix_PlayMusic(Mix_Music *music, int loops); */
-/* do_Mix_PlayMusic --- provide a Mix_PlayMusic() function for gawk */
+/* int Mix_Gawk_PlayVoice(Mix_Chunk *chunk,
+                          int priority,
+                          int max_instances,
+                          int loops); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_PlayVoice --- provide a Mix_Gawk_PlayVoice()
+                             function for gawk */
 
 static awk_value_t *
-do_Mix_PlayMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+do_Mix_Gawk_PlayVoice(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
 {
-    awk_value_t music_ptr_param;
+    awk_value_t chunk_ptr_param;
+    awk_value_t priority_param;
+    awk_value_t max_instances_param;
     awk_value_t loops_param;
-    uintptr_t music_ptr;
+    uintptr_t chunk_ptr;
+    int priority;
+    int max_instances;
     int loops;
+    int numchans;
+    int free_channel, oldest_instance, victim;
+    int instances;
+    int channel;
     int ret;
 
-    if (! get_argument(0, AWK_STRING, &music_ptr_param)
-        || ! get_argument(1, AWK_NUMBER, &loops_param)) {
-        warning(ext_id, _("Mix_PlayMusic: bad parameter(s)"));
+    if (! get_argument(0, AWK_STRING, &chunk_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &priority_param)) {
+        warning(ext_id, _("Mix_Gawk_PlayVoice: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    music_ptr = strtoull(music_ptr_param.str_value.str, (char **)NULL, 16);
+    if (nargs > 2) {
+        if (! get_argument(2, AWK_NUMBER, &max_instances_param)) {
+            warning(ext_id, _("Mix_Gawk_PlayVoice: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else
+        max_instances_param.num_value = 0;
+
+    if (nargs > 3) {
+        if (! get_argument(3, AWK_NUMBER, &loops_param)) {
+            warning(ext_id, _("Mix_Gawk_PlayVoice: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else
+        loops_param.num_value = 0;
+
+    chunk_ptr = strtoull(chunk_ptr_param.str_value.str, (char **)NULL, 16);
+    priority = priority_param.num_value;
+    max_instances = max_instances_param.num_value;
     loops = loops_param.num_value;
 
-    ret = Mix_PlayMusic((Mix_Music *)music_ptr, loops);
-    if (ret < 0)
-        update_ERRNO_string(_("Mix_PlayMusic failed"));
+    numchans = Mix_AllocateChannels(-1);
+    if (! ensure_channel_states(numchans)) {
+        update_ERRNO_string(_("Mix_Gawk_PlayVoice failed"));
+        RETURN_NOK;
+    }
 
-    return make_number(ret, result);
-}
+    free_channel = oldest_instance = victim = -1;
+    instances = 0;
+    for (channel = SDL_min(reserved_channels, numchans); channel < numchans;
+         channel++) {
+        struct channel_state *state = &channel_states[channel];
 
-/* int Mix_VolumeMusic(int volume); */
-/* do_Mix_VolumeMusic --- provide a Mix_VolumeMusic() function for gawk */
+        if (! Mix_Playing(channel)) {
+            if (free_channel < 0)
+                free_channel = channel;
+            continue;
+        }
+        if (! is_voice(channel))
+            continue;
+
+        if (state->chunk == (Mix_Chunk *)chunk_ptr) {
+            instances++;
+            if (oldest_instance < 0
+                || state->serial < channel_states[oldest_instance].serial)
+                oldest_instance = channel;
+        }
 
-static awk_value_t *
-do_Mix_VolumeMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
-{
-    awk_value_t volume_param;
-    int volume;
+        /* the lowest priority goes first, the oldest one among equals */
+        if (victim < 0 || state->priority < channel_states[victim].priority
+            || (state->priority == channel_states[victim].priority
+                && state->serial < channel_states[victim].serial))
+            victim = channel;
+    }
 
-    if (! get_argument(0, AWK_NUMBER, &volume_param)) {
-        warning(ext_id, _("Mix_VolumeMusic: bad parameter(s)"));
+    if (max_instances > 0 && instances >= max_instances)
+        channel = oldest_instance;
+    else if (free_channel >= 0)
+        channel = free_channel;
+    else if (victim >= 0 && channel_states[victim].priority <= priority)
+        channel = victim;
+    else {
+        mixer_stats.voices_dropped++;
+        update_ERRNO_string(_("Mix_Gawk_PlayVoice: no channel available"));
+        RETURN_NOK;
+    }
+
+    if (Mix_Playing(channel)) {
+        Mix_HaltChannel(channel);
+        mixer_stats.voices_stolen++;
+    }
+
+    ret = Mix_PlayChannel(channel, (Mix_Chunk *)chunk_ptr, loops);
+    if (ret < 0) {
+        channel_states[channel].chunk = NULL;
+        update_ERRNO_string(_("Mix_Gawk_PlayVoice failed"));
+        return make_number(ret, result);
+    }
+
+    channel_states[channel].chunk = (Mix_Chunk *)chunk_ptr;
+    channel_states[channel].priority = priority;
+    channel_states[channel].serial = ++voice_serial;
+    mixer_stats.voices_played++;
+
+    return make_number(ret, result);
+}
+
+/*----- Group Channels -----------------------------------------------------*/
+
+/* int Mix_ReserveChannels(int num); */
+/* do_Mix_ReserveChannels --- provide a Mix_ReserveChannels()
+                              function for gawk */
+
+static awk_value_t *
+do_Mix_ReserveChannels(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t num_param;
+    int num;
+
+    if (! get_argument(0, AWK_NUMBER, &num_param)) {
+        warning(ext_id, _("Mix_ReserveChannels: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    num = num_param.num_value;
+
+    /* SDL_mixer caps the count at the allocated channels */
+    reserved_channels = Mix_ReserveChannels(num);
+
+    return make_number(reserved_channels, result);
+}
+
+/* int Mix_GroupChannel(int which, int tag); */
+/* do_Mix_GroupChannel --- provide a Mix_GroupChannel() function for gawk */
+
+static awk_value_t *
+do_Mix_GroupChannel(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t which_param;
+    awk_value_t tag_param;
+    int which;
+    int tag;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &which_param)
+        || ! get_argument(1, AWK_NUMBER, &tag_param)) {
+        warning(ext_id, _("Mix_GroupChannel: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    which = which_param.num_value;
+    tag = tag_param.num_value;
+
+    ret = Mix_GroupChannel(which, tag);
+    if (ret == 0)
+        update_ERRNO_string(_("Mix_GroupChannel failed"));
+    else if (ensure_channel_states(which + 1))
+        channel_states[which].tag = tag;
+
+    return make_number(ret, result);
+}
+
+/* int Mix_GroupChannels(int from, int to, int tag); */
+/* do_Mix_GroupChannels --- provide a Mix_GroupChannels()
+                            function for gawk */
+
+static awk_value_t *
+do_Mix_GroupChannels(int nargs,
+                     awk_value_t *result,
+                     struct awk_ext_func *finfo)
+{
+    awk_value_t from_param, to_param;
+    awk_value_t tag_param;
+    int from, to;
+    int tag;
+    int numchans;
+    int ret;
+    int i;
+
+    if (! get_argument(0, AWK_NUMBER, &from_param)
+        || ! get_argument(1, AWK_NUMBER, &to_param)
+        || ! get_argument(2, AWK_NUMBER, &tag_param)) {
+        warning(ext_id, _("Mix_GroupChannels: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    from = from_param.num_value;
+    to = to_param.num_value;
+    tag = tag_param.num_value;
+
+    ret = Mix_GroupChannels(from, to, tag);
+
+    /* mirror the tags, SDL_mixer has no way to list a group */
+    numchans = SDL_min(to + 1, Mix_AllocateChannels(-1));
+    if (ensure_channel_states(numchans))
+        for (i = SDL_max(from, 0); i < numchans; i++)
+            channel_states[i].tag = tag;
+
+    return make_number(ret, result);
+}
+
+/* int Mix_GroupCount(int tag); */
+/* do_Mix_GroupCount --- provide a Mix_GroupCount() function for gawk */
+
+static awk_value_t *
+do_Mix_GroupCount(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t tag_param;
+    int tag;
+
+    if (! get_argument(0, AWK_NUMBER, &tag_param)) {
+        warning(ext_id, _("Mix_GroupCount: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    tag = tag_param.num_value;
+
+    return make_number(Mix_GroupCount(tag), result);
+}
+
+/* int Mix_FadeOutGroup(int tag, int ms); */
+/* do_Mix_FadeOutGroup --- provide a Mix_FadeOutGroup() function for gawk */
+
+static awk_value_t *
+do_Mix_FadeOutGroup(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t tag_param;
+    awk_value_t ms_param;
+    int tag;
+    int ms;
+
+    if (! get_argument(0, AWK_NUMBER, &tag_param)
+        || ! get_argument(1, AWK_NUMBER, &ms_param)) {
+        warning(ext_id, _("Mix_FadeOutGroup: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    tag = tag_param.num_value;
+    ms = ms_param.num_value;
+
+    return make_number(Mix_FadeOutGroup(tag, ms), result);
+}
+
+/* int Mix_HaltGroup(int tag); */
+/* do_Mix_HaltGroup --- provide a Mix_HaltGroup() function for gawk */
+
+static awk_value_t *
+do_Mix_HaltGroup(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t tag_param;
+    int tag;
+
+    if (! get_argument(0, AWK_NUMBER, &tag_param)) {
+        warning(ext_id, _("Mix_HaltGroup: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    tag = tag_param.num_value;
+
+    return make_number(Mix_HaltGroup(tag), result);
+}
+
+/* in_group --- tell whether a channel belongs to a group (-1 for all) */
+
+static awk_bool_t
+in_group(int channel, int tag)
+{
+    if (tag == -1)
+        return awk_true;
+    return channel < num_channel_states && channel_states[channel].tag == tag;
+}
+
+/* int Mix_Gawk_GroupVolume(int tag, int volume); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_GroupVolume --- provide a Mix_Gawk_GroupVolume()
+                               function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_GroupVolume(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t tag_param;
+    awk_value_t volume_param;
+    int tag;
+    int volume;
+    int numchans;
+    int count;
+    int channel;
+
+    if (! get_argument(0, AWK_NUMBER, &tag_param)
+        || ! get_argument(1, AWK_NUMBER, &volume_param)) {
+        warning(ext_id, _("Mix_Gawk_GroupVolume: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    tag = tag_param.num_value;
+    volume = volume_param.num_value;
+
+    numchans = Mix_AllocateChannels(-1);
+    count = 0;
+    for (channel = 0; channel < numchans; channel++)
+        if (in_group(channel, tag)) {
+            Mix_Volume(channel, volume);
+            count++;
+        }
+
+    return make_number(count, result);
+}
+
+/* int Mix_Gawk_GroupPanning(int tag, Uint8 left, Uint8 right); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_GroupPanning --- provide a Mix_Gawk_GroupPanning()
+                                function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_GroupPanning(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t tag_param;
+    awk_value_t left_param, right_param;
+    int tag;
+    uint8_t left, right;
+    int numchans;
+    int updated;
+    int channel;
+
+    if (! get_argument(0, AWK_NUMBER, &tag_param)
+        || ! get_argument(1, AWK_NUMBER, &left_param)
+        || ! get_argument(2, AWK_NUMBER, &right_param)) {
+        warning(ext_id, _("Mix_Gawk_GroupPanning: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    tag = tag_param.num_value;
+    left = left_param.num_value;
+    right = right_param.num_value;
+
+    numchans = Mix_AllocateChannels(-1);
+    if (! ensure_channel_states(numchans)) {
+        update_ERRNO_string(_("Mix_Gawk_GroupPanning failed"));
+        RETURN_NOK;
+    }
+
+    /* skip channels that already have this panning, and still have the
+       effect that carries it */
+    updated = 0;
+    for (channel = 0; channel < numchans; channel++) {
+        struct channel_state *state = &channel_states[channel];
+        int generation;
+
+        if (! in_group(channel, tag))
+            continue;
+
+        generation = channel_generation(channel);
+        if (state->pan == (left << 8 | right) && generation >= 0
+            && generation == state->generation)
+            continue;
+
+        if (Mix_SetPanning(channel, left, right) == 0) {
+            state->pan = -1;
+            continue;
+        }
+        state->angle = -1;
+        state->pan = left << 8 | right;
+        state->generation = generation;
+        updated++;
+    }
+
+    return make_number(updated, result);
+}
+
+/*----- Play Music ---------------------------------------------------------*/
+
+/* Mix_Music *Mix_LoadMUS(const char *file); */
+/* do_Mix_LoadMUS --- provide a Mix_LoadMUS() function for gawk */
+
+static awk_value_t *
+do_Mix_LoadMUS(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    Mix_Music *music;
+    awk_value_t file_param;
+    const char *file;
+
+    if (! get_argument(0, AWK_STRING, &file_param)) {
+        warning(ext_id, _("Mix_LoadMUS: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    file = file_param.str_value.str;
+
+    music = Mix_LoadMUS(file);
+
+    if (music) {
+        char music_addr[20];
+        // NOLINTNEXTLINE
+        snprintf(music_addr, sizeof(music_addr), "%p", music);
+        return make_string_malloc(music_addr, strlen(music_addr), result);
+    }
+
+    update_ERRNO_string(_("Mix_LoadMUS failed"));
+    return make_null_string(result);
+}
+
+/* void Mix_FreeMusic(Mix_Music *music); */
+/* do_Mix_FreeMusic --- provide a Mix_FreeMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_FreeMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t music_ptr_param;
+    uintptr_t music_ptr;
+
+    if (! get_argument(0, AWK_STRING, &music_ptr_param)) {
+        warning(ext_id, _("Mix_FreeMusic: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    music_ptr = strtoull(music_ptr_param.str_value.str, (char **)NULL, 16);
+
+    Mix_FreeMusic((Mix_Music *)music_ptr);
+    RETURN_OK;
+}
+
+/* int Mix_PlayMusic(Mix_Music *music, int loops); */
+/* do_Mix_PlayMusic --- provide a Mix_PlayMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_PlayMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t music_ptr_param;
+    awk_value_t loops_param;
+    uintptr_t music_ptr;
+    int loops;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &music_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &loops_param)) {
+        warning(ext_id, _("Mix_PlayMusic: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    music_ptr = strtoull(music_ptr_param.str_value.str, (char **)NULL, 16);
+    loops = loops_param.num_value;
+
+    ret = Mix_PlayMusic((Mix_Music *)music_ptr, loops);
+    if (ret < 0)
+        update_ERRNO_string(_("Mix_PlayMusic failed"));
+
+    return make_number(ret, result);
+}
+
+/* int Mix_VolumeMusic(int volume); */
+/* do_Mix_VolumeMusic --- provide a Mix_VolumeMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_VolumeMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t volume_param;
+    int volume;
+
+    if (! get_argument(0, AWK_NUMBER, &volume_param)) {
+        warning(ext_id, _("Mix_VolumeMusic: bad parameter(s)"));
         RETURN_NOK;
     }
 
@@ -518,180 +1490,2502 @@ do_Mix_SetMusicPosition(int nargs,
         RETURN_NOK;
     }
 
-    position = position_param.num_value;
+    position = position_param.num_value;
+
+    ret = Mix_SetMusicPosition(position);
+    if (ret < 0)
+        update_ERRNO_string(_("Mix_SetMusicPosition failed"));
+
+    return make_number(ret, result);
+}
+
+/* int Mix_SetMusicCMD(const char *command); */
+/* do_Mix_SetMusicCMD --- provide a Mix_SetMusicCMD() function for gawk */
+
+static awk_value_t *
+do_Mix_SetMusicCMD(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t command_param;
+    const char *command;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &command_param)) {
+        warning(ext_id, _("Mix_SetMusicCMD: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    command = command_param.str_value.str;
+
+    ret = Mix_SetMusicCMD(command);
+    if (ret < 0)
+        update_ERRNO_string(_("Mix_SetMusicCMD failed"));
+
+    return make_number(ret, result);
+}
+
+/* int Mix_HaltMusic(void); */
+/* do_Mix_HaltMusic --- provide a Mix_HaltMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_HaltMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    return make_number(Mix_HaltMusic(), result);
+}
+
+/* int Mix_PlayingMusic(void); */
+/* do_Mix_PlayingMusic --- provide a Mix_PlayingMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_PlayingMusic(int nargs,
+                    awk_value_t *result,
+                    struct awk_ext_func *finfo)
+{
+    return make_number(Mix_PlayingMusic(), result);
+}
+
+/* int Mix_FadeInMusic(Mix_Music *music, int loops, int ms); */
+/* do_Mix_FadeInMusic --- provide a Mix_FadeInMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_FadeInMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t music_ptr_param;
+    awk_value_t loops_param;
+    awk_value_t ms_param;
+    uintptr_t music_ptr;
+    int loops;
+    int ms;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &music_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &loops_param)
+        || ! get_argument(2, AWK_NUMBER, &ms_param)) {
+        warning(ext_id, _("Mix_FadeInMusic: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    music_ptr = strtoull(music_ptr_param.str_value.str, (char **)NULL, 16);
+    loops = loops_param.num_value;
+    ms = ms_param.num_value;
+
+    ret = Mix_FadeInMusic((Mix_Music *)music_ptr, loops, ms);
+    if (ret < 0)
+        update_ERRNO_string(_("Mix_FadeInMusic failed"));
+
+    return make_number(ret, result);
+}
+
+/* int Mix_FadeOutMusic(int ms); */
+/* do_Mix_FadeOutMusic --- provide a Mix_FadeOutMusic() function for gawk */
+
+static awk_value_t *
+do_Mix_FadeOutMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t ms_param;
+    int ms;
+
+    if (! get_argument(0, AWK_NUMBER, &ms_param)) {
+        warning(ext_id, _("Mix_FadeOutMusic: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    ms = ms_param.num_value;
+
+    return make_number(Mix_FadeOutMusic(ms), result);
+}
+
+enum music_play {
+    MUSIC_PLAY_NONE,
+    MUSIC_PLAY_PENDING,       /* start once loaded */
+    MUSIC_PLAY_STARTED,
+};
+
+/* a Mix_LoadMUS() running on a worker thread */
+struct music_load {
+    struct music_load *next;
+    SDL_Thread *thread;
+    char *file;
+    Mix_Music *music;
+    SDL_atomic_t state;       /* 0 loading, 1 loaded, -1 failed */
+    char error[256];
+    enum music_play play;
+    int loops;
+    int fade_ms;
+};
+
+static struct music_load *music_loads;
+
+/* find_music_load --- look up an asynchronous load handle */
+
+static struct music_load *
+find_music_load(const char *handle)
+{
+    struct music_load *load;
+    uintptr_t load_ptr;
+
+    load_ptr = strtoull(handle, (char **)NULL, 16);
+    for (load = music_loads; load != NULL; load = load->next)
+        if ((uintptr_t)load == load_ptr)
+            return load;
+
+    return NULL;
+}
+
+/* load_music_thread --- open and probe the music file off the main loop */
+
+static int
+load_music_thread(void *data)
+{
+    struct music_load *load = data;
+
+    load->music = Mix_LoadMUS(load->file);
+    if (load->music == NULL)
+        snprintf(load->error, sizeof(load->error), "%s", Mix_GetError());
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&load->state, load->music != NULL ? 1 : -1);
+    return 0;
+}
+
+/* start_music --- carry out a pending "play when ready" request */
+
+static void
+start_music(struct music_load *load)
+{
+    /* there is a single music stream, so the crossfade is a fade-out of
+       the current track followed by a fade-in of the new one */
+    if (load->fade_ms > 0 && Mix_PlayingMusic()) {
+        if (Mix_FadingMusic() != MIX_FADING_OUT)
+            Mix_FadeOutMusic(load->fade_ms);
+        return;
+    }
+
+    if (Mix_FadeInMusic(load->music, load->loops, load->fade_ms) < 0)
+        update_ERRNO_string(_("Mix_FadeInMusic failed"));
+    load->play = MUSIC_PLAY_STARTED;
+}
+
+/* finish_music_load --- join the worker and free the handle, returning
+                         the music it loaded (NULL if the load failed) */
+
+static Mix_Music *
+finish_music_load(struct music_load *load)
+{
+    struct music_load **prev;
+    Mix_Music *music;
+
+    SDL_WaitThread(load->thread, NULL);
+    music = load->music;
+
+    for (prev = &music_loads; *prev != load; prev = &(*prev)->next)
+        ;
+    *prev = load->next;
+    gawk_free(load->file);
+    gawk_free(load);
+
+    return music;
+}
+
+/* free_music_loads --- join every outstanding load before audio closes */
+
+static void
+free_music_loads(void)
+{
+    Mix_Music *music;
+
+    while (music_loads != NULL)
+        if ((music = finish_music_load(music_loads)) != NULL)
+            Mix_FreeMusic(music);
+}
+
+/* Mix_MusicLoad *Mix_Gawk_LoadMUSAsync(const char *file); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_LoadMUSAsync --- provide a Mix_Gawk_LoadMUSAsync()
+                                function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_LoadMUSAsync(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t file_param;
+    struct music_load *load;
+    char load_addr[20];
+
+    if (! get_argument(0, AWK_STRING, &file_param)) {
+        warning(ext_id, _("Mix_Gawk_LoadMUSAsync: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    load = gawk_calloc(1, sizeof(*load));
+    if (load == NULL
+        || (load->file = gawk_malloc(file_param.str_value.len + 1)) == NULL) {
+        gawk_free(load);
+        update_ERRNO_string(_("Mix_Gawk_LoadMUSAsync failed"));
+        return make_null_string(result);
+    }
+    memcpy(load->file, file_param.str_value.str, file_param.str_value.len);
+    load->file[file_param.str_value.len] = '\0';
+
+    load->thread = SDL_CreateThread(load_music_thread, "LoadMUS", load);
+    if (load->thread == NULL) {
+        gawk_free(load->file);
+        gawk_free(load);
+        update_ERRNO_string(_("Mix_Gawk_LoadMUSAsync failed"));
+        return make_null_string(result);
+    }
+
+    load->next = music_loads;
+    music_loads = load;
+
+    // NOLINTNEXTLINE
+    snprintf(load_addr, sizeof(load_addr), "%p", load);
+    return make_string_malloc(load_addr, strlen(load_addr), result);
+}
+
+/* int Mix_Gawk_PlayMUSWhenReady(Mix_MusicLoad *load, int loops, int ms); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_PlayMUSWhenReady --- provide a Mix_Gawk_PlayMUSWhenReady()
+                                    function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_PlayMUSWhenReady(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    awk_value_t load_ptr_param;
+    awk_value_t loops_param;
+    awk_value_t ms_param;
+    struct music_load *load;
+
+    if (! get_argument(0, AWK_STRING, &load_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &loops_param)
+        || (load = find_music_load(load_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("Mix_Gawk_PlayMUSWhenReady: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (nargs > 2) {
+        if (! get_argument(2, AWK_NUMBER, &ms_param)) {
+            warning(ext_id,
+                    _("Mix_Gawk_PlayMUSWhenReady: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else
+        ms_param.num_value = 0;
+
+    load->loops = loops_param.num_value;
+    load->fade_ms = SDL_max(0, ms_param.num_value);
+    load->play = MUSIC_PLAY_PENDING;
+
+    RETURN_OK;
+}
+
+/* int Mix_Gawk_PollMUS(Mix_MusicLoad *load); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_PollMUS --- provide a Mix_Gawk_PollMUS() function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_PollMUS(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t load_ptr_param;
+    struct music_load *load;
+    int state;
+
+    if (! get_argument(0, AWK_STRING, &load_ptr_param)
+        || (load = find_music_load(load_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("Mix_Gawk_PollMUS: bad parameter(s)"));
+        return make_number(-1, result);
+    }
+
+    state = SDL_AtomicGet(&load->state);
+    SDL_MemoryBarrierAcquire();
+
+    if (state < 0) {
+        load->play = MUSIC_PLAY_NONE;
+        update_ERRNO_string(load->error);
+        return make_number(-1, result);
+    }
+
+    /* a requested track counts as ready once it has started */
+    if (state > 0 && load->play == MUSIC_PLAY_PENDING)
+        start_music(load);
+    if (load->play == MUSIC_PLAY_PENDING)
+        state = 0;
+
+    return make_number(state, result);
+}
+
+/* Mix_Music *Mix_Gawk_GetMUS(Mix_MusicLoad *load); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_GetMUS --- provide a Mix_Gawk_GetMUS() function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_GetMUS(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t load_ptr_param;
+    struct music_load *load;
+    Mix_Music *music;
+
+    if (! get_argument(0, AWK_STRING, &load_ptr_param)
+        || (load = find_music_load(load_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("Mix_Gawk_GetMUS: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* waits for the worker if it is still loading, and frees the handle;
+       the music then belongs to the script like one from Mix_LoadMUS() */
+    SDL_WaitThread(load->thread, NULL);
+    load->thread = NULL;
+    if (load->music == NULL)
+        update_ERRNO_string(load->error);
+    else if (load->play == MUSIC_PLAY_PENDING) {
+        /* the handle goes away, so the request cannot wait any longer */
+        start_music(load);
+        if (load->play == MUSIC_PLAY_PENDING)
+            update_ERRNO_string(
+                _("Mix_Gawk_GetMUS: music not started, still fading out"));
+    }
+    music = finish_music_load(load);
+
+    if (music) {
+        char music_addr[20];
+        // NOLINTNEXTLINE
+        snprintf(music_addr, sizeof(music_addr), "%p", music);
+        return make_string_malloc(music_addr, strlen(music_addr), result);
+    }
+
+    return make_null_string(result);
+}
+
+/* void Mix_Gawk_FreeMUSAsync(Mix_MusicLoad *load); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_FreeMUSAsync --- provide a Mix_Gawk_FreeMUSAsync()
+                                function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_FreeMUSAsync(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t load_ptr_param;
+    struct music_load *load;
+    Mix_Music *music;
+
+    if (! get_argument(0, AWK_STRING, &load_ptr_param)
+        || (load = find_music_load(load_ptr_param.str_value.str)) == NULL) {
+        warning(ext_id, _("Mix_Gawk_FreeMUSAsync: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* cancels a pending play request and stops the track if it started */
+    if ((music = finish_music_load(load)) != NULL)
+        Mix_FreeMusic(music);
+
+    RETURN_OK;
+}
+
+/*----- Handle Effects -----------------------------------------------------*/
+
+/* int Mix_SetPanning(int channel, Uint8 left, Uint8 right); */
+/* do_Mix_SetPanning --- provide a Mix_SetPanning() function for gawk */
+
+static awk_value_t *
+do_Mix_SetPanning(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t left_param, right_param;
+    int channel;
+    uint8_t left, right;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &left_param)
+        || ! get_argument(2, AWK_NUMBER, &right_param)) {
+        warning(ext_id, _("Mix_SetPanning: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+    left = left_param.num_value;
+    right = right_param.num_value;
+
+    ret = Mix_SetPanning(channel, left, right);
+    if (ret == 0)
+        update_ERRNO_string(_("Mix_SetPanning failed"));
+    forget_position(channel);
+
+    return make_number(ret, result);
+}
+
+/* int Mix_SetDistance(int channel, Uint8 distance); */
+/* do_Mix_SetDistance --- provide a Mix_SetDistance() function for gawk */
+
+static awk_value_t *
+do_Mix_SetDistance(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t distance_param;
+    int channel;
+    uint8_t distance;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &distance_param)) {
+        warning(ext_id, _("Mix_SetDistance: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+    distance = distance_param.num_value;
+
+    ret = Mix_SetDistance(channel, distance);
+    if (ret == 0)
+        update_ERRNO_string(_("Mix_SetDistance failed"));
+    forget_position(channel);
+
+    return make_number(ret, result);
+}
+
+/* int Mix_SetPosition(int channel, Sint16 angle, Uint8 distance); */
+/* do_Mix_SetPosition --- provide a Mix_SetPosition() function for gawk */
+
+static awk_value_t *
+do_Mix_SetPosition(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t angle_param;
+    awk_value_t distance_param;
+    int channel;
+    int16_t angle;
+    uint8_t distance;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &angle_param)
+        || ! get_argument(2, AWK_NUMBER, &distance_param)) {
+        warning(ext_id, _("Mix_SetPosition: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+    angle = angle_param.num_value;
+    distance = distance_param.num_value;
+
+    ret = Mix_SetPosition(channel, angle, distance);
+    if (ret == 0)
+        update_ERRNO_string(_("Mix_SetPosition failed"));
+    forget_position(channel);
+
+    return make_number(ret, result);
+}
+
+/* int Mix_SetReverseStereo(int channel, int flip); */
+/* do_Mix_SetReverseStereo --- provide a Mix_SetReverseStereo()
+                               function for gawk */
+
+static awk_value_t *
+do_Mix_SetReverseStereo(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t flip_param;
+    int channel;
+    int flip;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &flip_param)) {
+        warning(ext_id, _("Mix_SetReverseStereo: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+    flip = flip_param.num_value;
+
+    ret = Mix_SetReverseStereo(channel, flip);
+    if (ret == 0)
+        update_ERRNO_string(_("Mix_SetReverseStereo failed"));
+
+    return make_number(ret, result);
+}
+
+#define MAX_EFFECTS 8
+#define MAX_EFFECT_PARAMS 4
+#define MAX_EFFECT_CHANNELS 8
+#define EFFECT_BLOCK_FRAMES 256
+#define MAX_DELAY_MS 2000
+
+enum effect_type {
+    EFFECT_LOWPASS,
+    EFFECT_HIGHPASS,
+    EFFECT_DELAY,
+    EFFECT_REVERB,
+    EFFECT_LIMITER,
+};
+
+static const struct effect_desc {
+    const char *name;
+    const char *params[MAX_EFFECT_PARAMS];
+    double defaults[MAX_EFFECT_PARAMS];
+} effect_descs[] = {
+    /* cutoff in Hz */
+    { "lowpass", { "cutoff", "q" }, { 1000, 0.7071 } },
+    { "highpass", { "cutoff", "q" }, { 1000, 0.7071 } },
+    /* time in ms, feedback in [-0.98, 0.98], mix is the wet/dry balance */
+    { "delay", { "time", "feedback", "mix" }, { 250, 0.4, 0.3 } },
+    /* room, damp and mix in [0, 1] */
+    { "reverb", { "room", "damp", "mix" }, { 0.5, 0.5, 0.25 } },
+    /* threshold in [0, 1], release in ms */
+    { "limiter", { "threshold", "release" }, { 0.9, 50 } },
+};
+
+/* Schroeder reverb tunings in samples at 44100 Hz (from Freeverb) */
+static const int reverb_comb_tuning[] = { 1116, 1188, 1277, 1356 };
+static const int reverb_allpass_tuning[] = { 556, 441 };
+#define REVERB_STEREO_SPREAD 23
+#define NUM_COMBS (sizeof(reverb_comb_tuning) / sizeof(int))
+#define NUM_ALLPASSES (sizeof(reverb_allpass_tuning) / sizeof(int))
+
+struct reverb_line {
+    float *buf;
+    int size;
+    int pos;
+    float store;          /* damping filter state, combs only */
+};
+
+struct effect {
+    enum effect_type type;
+    double params[MAX_EFFECT_PARAMS];
+    /* biquad filters */
+    float b0, b1, b2, a1, a2;
+    float z1[MAX_EFFECT_CHANNELS], z2[MAX_EFFECT_CHANNELS];
+    /* delay and reverb, clamped so the feedback loops stay stable */
+    float feedback;
+    float damp;
+    float mix;
+    /* delay */
+    float *line;
+    int line_frames;
+    int line_pos;
+    /* reverb */
+    float *reverb_buf;
+    struct reverb_line combs[MAX_EFFECT_CHANNELS][NUM_COMBS];
+    struct reverb_line allpasses[MAX_EFFECT_CHANNELS][NUM_ALLPASSES];
+    /* limiter */
+    float gain;
+    float release_coef;
+};
+
+struct effect_chain {
+    struct effect_chain *next;
+    SDL_mutex *lock;          /* held while the chain is processed */
+    int freq;
+    uint16_t format;
+    int channels;
+    awk_bool_t registered;
+    int channel;
+    int num_effects;
+    struct effect effects[MAX_EFFECTS];
+    float work[EFFECT_BLOCK_FRAMES * MAX_EFFECT_CHANNELS];
+};
+
+static struct effect_chain *effect_chains;
+
+/* find_effect_chain --- look up an effect chain handle */
+
+static struct effect_chain *
+find_effect_chain(const char *handle)
+{
+    struct effect_chain *chain;
+    uintptr_t chain_ptr;
+
+    chain_ptr = strtoull(handle, (char **)NULL, 16);
+    for (chain = effect_chains; chain != NULL; chain = chain->next)
+        if ((uintptr_t)chain == chain_ptr)
+            return chain;
+
+    return NULL;
+}
+
+/* update_effect --- derive the effect coefficients from its parameters */
+
+static void
+update_effect(struct effect *effect, int freq)
+{
+    double *p = effect->params;
+    double w0, alpha, cosw0, a0;
+    double cutoff;
+    int frames;
+
+    switch (effect->type) {
+    case EFFECT_LOWPASS:
+    case EFFECT_HIGHPASS:
+        /* RBJ audio EQ cookbook */
+        cutoff = SDL_max(10, SDL_min(p[0], freq * 0.45));
+        w0 = 2 * M_PI * cutoff / freq;
+        cosw0 = cos(w0);
+        alpha = sin(w0) / (2 * SDL_max(p[1], 0.1));
+        a0 = 1 + alpha;
+        if (effect->type == EFFECT_LOWPASS) {
+            effect->b0 = (1 - cosw0) / 2 / a0;
+            effect->b1 = (1 - cosw0) / a0;
+        } else {
+            effect->b0 = (1 + cosw0) / 2 / a0;
+            effect->b1 = -(1 + cosw0) / a0;
+        }
+        effect->b2 = effect->b0;
+        effect->a1 = -2 * cosw0 / a0;
+        effect->a2 = (1 - alpha) / a0;
+        break;
+    case EFFECT_DELAY:
+        frames = SDL_max(1, SDL_min(p[0], MAX_DELAY_MS) * freq / 1000);
+        effect->line_frames = SDL_min(frames, MAX_DELAY_MS * freq / 1000);
+        if (effect->line_pos >= effect->line_frames)
+            effect->line_pos = 0;
+        effect->feedback = SDL_max(-0.98, SDL_min(p[1], 0.98));
+        effect->mix = SDL_max(0, SDL_min(p[2], 1));
+        break;
+    case EFFECT_REVERB:
+        effect->feedback = 0.7 + 0.28 * SDL_max(0, SDL_min(p[0], 1));
+        effect->damp = 0.4 * SDL_max(0, SDL_min(p[1], 1));
+        effect->mix = SDL_max(0, SDL_min(p[2], 1));
+        break;
+    case EFFECT_LIMITER:
+        effect->release_coef = exp(-1000.0 / (SDL_max(p[1], 1) * freq));
+        break;
+    default:
+        break;
+    }
+}
+
+/* prepare_effect --- allocate the effect state for the mixer format */
+
+static awk_bool_t
+prepare_effect(struct effect *effect, int freq, int channels)
+{
+    size_t size;
+    float *buf;
+    unsigned i;
+    int c;
+
+    memset(effect->z1, 0, sizeof(effect->z1));
+    memset(effect->z2, 0, sizeof(effect->z2));
+    effect->gain = 1;
+
+    switch (effect->type) {
+    case EFFECT_DELAY:
+        /* sized for the longest delay, so "time" can change while playing */
+        size = (size_t)(MAX_DELAY_MS * freq / 1000) * channels;
+        buf = gawk_calloc(size, sizeof(float));
+        if (buf == NULL)
+            return awk_false;
+        gawk_free(effect->line);
+        effect->line = buf;
+        effect->line_pos = 0;
+        break;
+    case EFFECT_REVERB:
+        size = 0;
+        for (c = 0; c < channels; c++) {
+            for (i = 0; i < NUM_COMBS; i++)
+                size += (reverb_comb_tuning[i] + c * REVERB_STEREO_SPREAD)
+                        * freq / 44100 + 1;
+            for (i = 0; i < NUM_ALLPASSES; i++)
+                size += (reverb_allpass_tuning[i] + c * REVERB_STEREO_SPREAD)
+                        * freq / 44100 + 1;
+        }
+        buf = gawk_calloc(size, sizeof(float));
+        if (buf == NULL)
+            return awk_false;
+        gawk_free(effect->reverb_buf);
+        effect->reverb_buf = buf;
+        for (c = 0; c < channels; c++) {
+            for (i = 0; i < NUM_COMBS; i++) {
+                struct reverb_line *l = &effect->combs[c][i];
+                l->size = (reverb_comb_tuning[i] + c * REVERB_STEREO_SPREAD)
+                          * freq / 44100 + 1;
+                l->buf = buf;
+                l->pos = 0;
+                l->store = 0;
+                buf += l->size;
+            }
+            for (i = 0; i < NUM_ALLPASSES; i++) {
+                struct reverb_line *l = &effect->allpasses[c][i];
+                l->size = (reverb_allpass_tuning[i]
+                           + c * REVERB_STEREO_SPREAD)
+                          * freq / 44100 + 1;
+                l->buf = buf;
+                l->pos = 0;
+                buf += l->size;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    update_effect(effect, freq);
+    return awk_true;
+}
+
+/* run_biquad --- filter interleaved frames, one channel at a time */
+
+static void
+run_biquad(struct effect *effect, float *work, int frames, int channels)
+{
+    const float b0 = effect->b0, b1 = effect->b1, b2 = effect->b2;
+    const float a1 = effect->a1, a2 = effect->a2;
+    int i, c;
+
+    for (c = 0; c < channels; c++) {
+        float z1 = effect->z1[c], z2 = effect->z2[c];
+        float *x = work + c;
+
+        /* transposed direct form II */
+        for (i = 0; i < frames; i++, x += channels) {
+            float y = b0 * *x + z1;
+            z1 = b1 * *x - a1 * y + z2;
+            z2 = b2 * *x - a2 * y;
+            *x = y;
+        }
+        effect->z1[c] = z1;
+        effect->z2[c] = z2;
+    }
+}
+
+/* run_delay --- apply a feedback delay line */
+
+static void
+run_delay(struct effect *effect, float *work, int frames, int channels)
+{
+    const float feedback = effect->feedback;
+    const float mix = effect->mix;
+    int i, c;
+
+    for (i = 0; i < frames; i++) {
+        float *tap = effect->line + (size_t)effect->line_pos * channels;
+        float *x = work + i * channels;
+
+        for (c = 0; c < channels; c++) {
+            float delayed = tap[c];
+            tap[c] = x[c] + delayed * feedback;
+            x[c] += (delayed - x[c]) * mix;
+        }
+        if (++effect->line_pos >= effect->line_frames)
+            effect->line_pos = 0;
+    }
+}
+
+/* run_reverb --- apply a Schroeder reverb (parallel combs, serial
+                  allpasses) */
+
+static void
+run_reverb(struct effect *effect, float *work, int frames, int channels)
+{
+    const float feedback = effect->feedback;
+    const float damp = effect->damp;
+    const float mix = effect->mix;
+    unsigned k;
+    int i, c;
+
+    for (c = 0; c < channels; c++) {
+        float *x = work + c;
+
+        for (i = 0; i < frames; i++, x += channels) {
+            float input = *x * 0.05f;
+            float wet = 0;
+
+            for (k = 0; k < NUM_COMBS; k++) {
+                struct reverb_line *l = &effect->combs[c][k];
+                float out = l->buf[l->pos];
+
+                l->store = out * (1 - damp) + l->store * damp;
+                l->buf[l->pos] = input + l->store * feedback;
+                if (++l->pos >= l->size)
+                    l->pos = 0;
+                wet += out;
+            }
+            for (k = 0; k < NUM_ALLPASSES; k++) {
+                struct reverb_line *l = &effect->allpasses[c][k];
+                float out = l->buf[l->pos];
+
+                l->buf[l->pos] = wet + out * 0.5f;
+                if (++l->pos >= l->size)
+                    l->pos = 0;
+                wet = out - wet;
+            }
+            *x += (wet - *x) * mix;
+        }
+    }
+}
+
+/* run_limiter --- apply a peak limiter linked across channels */
+
+static void
+run_limiter(struct effect *effect, float *work, int frames, int channels)
+{
+    const float threshold = SDL_max(effect->params[0], 0.01);
+    const float release_coef = effect->release_coef;
+    float gain = effect->gain;
+    int i, c;
+
+    for (i = 0; i < frames; i++) {
+        float *x = work + i * channels;
+        float peak = 0, target;
+
+        for (c = 0; c < channels; c++)
+            peak = SDL_max(peak, fabsf(x[c]));
+        target = peak > threshold ? threshold / peak : 1.0f;
+        /* attack is instant, release is exponential */
+        if (target < gain)
+            gain = target;
+        else
+            gain = target + (gain - target) * release_coef;
+        for (c = 0; c < channels; c++)
+            x[c] *= gain;
+    }
+    effect->gain = gain;
+}
+
+/* load_block --- convert mixer samples to floats */
+
+static void
+load_block(float *work, const uint8_t *src, int count, uint16_t format)
+{
+    int i;
+
+    /* the common formats get plain loops the compiler can vectorize */
+    if (format == AUDIO_S16SYS) {
+        const int16_t *s = (const int16_t *)src;
+        for (i = 0; i < count; i++)
+            work[i] = s[i] * (1.0f / 32768.0f);
+    } else if (format == AUDIO_F32SYS) {
+        memcpy(work, src, count * sizeof(float));
+    } else {
+        int size = SDL_AUDIO_BITSIZE(format) / 8;
+        for (i = 0; i < count; i++)
+            work[i] = read_sample(src + i * size, format);
+    }
+}
+
+/* store_block --- convert floats back to mixer samples */
+
+static void
+store_block(uint8_t *dst, const float *work, int count, uint16_t format)
+{
+    int i;
+
+    if (format == AUDIO_S16SYS) {
+        int16_t *d = (int16_t *)dst;
+        for (i = 0; i < count; i++) {
+            float v = work[i] * 32767.0f;
+            v = v > 32767.0f ? 32767.0f : v;
+            v = v < -32768.0f ? -32768.0f : v;
+            d[i] = (int16_t)v;
+        }
+    } else if (format == AUDIO_F32SYS) {
+        memcpy(dst, work, count * sizeof(float));
+    } else {
+        int size = SDL_AUDIO_BITSIZE(format) / 8;
+        for (i = 0; i < count; i++)
+            write_sample(dst + i * size, work[i], format);
+    }
+}
+
+/* effect_chain_callback --- run an effect chain inside the audio callback */
+
+static void
+effect_chain_callback(int chan, void *stream, int len, void *udata)
+{
+    struct effect_chain *chain = udata;
+    int sample_size = SDL_AUDIO_BITSIZE(chain->format) / 8;
+    int frame_size = sample_size * chain->channels;
+    int frames = len / frame_size;
+    uint8_t *data = stream;
+    uint64_t start = dsp_begin();
+    int i;
+
+    SDL_LockMutex(chain->lock);
+    while (frames > 0) {
+        int n = SDL_min(frames, EFFECT_BLOCK_FRAMES);
+        int count = n * chain->channels;
+
+        load_block(chain->work, data, count, chain->format);
+        for (i = 0; i < chain->num_effects; i++) {
+            struct effect *effect = &chain->effects[i];
+
+            switch (effect->type) {
+            case EFFECT_LOWPASS:
+            case EFFECT_HIGHPASS:
+                run_biquad(effect, chain->work, n, chain->channels);
+                break;
+            case EFFECT_DELAY:
+                run_delay(effect, chain->work, n, chain->channels);
+                break;
+            case EFFECT_REVERB:
+                run_reverb(effect, chain->work, n, chain->channels);
+                break;
+            case EFFECT_LIMITER:
+                run_limiter(effect, chain->work, n, chain->channels);
+                break;
+            }
+        }
+        store_block(data, chain->work, count, chain->format);
+
+        data += n * frame_size;
+        frames -= n;
+    }
+    SDL_UnlockMutex(chain->lock);
+    dsp_end(start);
+}
+
+/* effect_chain_done --- forget the channel once SDL_mixer drops the chain */
+
+static void
+effect_chain_done(int chan, void *udata)
+{
+    struct effect_chain *chain = udata;
+
+    chain->registered = awk_false;
+}
+
+/* Mix_EffectChain *Mix_Gawk_CreateEffectChain(void); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_CreateEffectChain --- provide a Mix_Gawk_CreateEffectChain()
+                                     function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_CreateEffectChain(int nargs,
+                              awk_value_t *result,
+                              struct awk_ext_func *finfo)
+{
+    struct effect_chain *chain;
+    char chain_addr[20];
+
+    chain = gawk_calloc(1, sizeof(*chain));
+    if (chain == NULL || (chain->lock = SDL_CreateMutex()) == NULL) {
+        gawk_free(chain);
+        update_ERRNO_string(_("Mix_Gawk_CreateEffectChain failed"));
+        return make_null_string(result);
+    }
+
+    chain->next = effect_chains;
+    effect_chains = chain;
+
+    // NOLINTNEXTLINE
+    snprintf(chain_addr, sizeof(chain_addr), "%p", chain);
+    return make_string_malloc(chain_addr, strlen(chain_addr), result);
+}
+
+/* int Mix_Gawk_AddEffect(Mix_EffectChain *chain, const char *type); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_AddEffect --- provide a Mix_Gawk_AddEffect()
+                             function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_AddEffect(int nargs,
+                      awk_value_t *result,
+                      struct awk_ext_func *finfo)
+{
+    awk_value_t chain_ptr_param;
+    awk_value_t type_param;
+    struct effect_chain *chain;
+    struct effect effect;
+    size_t type;
+    int i;
+
+    if (! get_argument(0, AWK_STRING, &chain_ptr_param)
+        || ! get_argument(1, AWK_STRING, &type_param)
+        || (chain = find_effect_chain(chain_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_AddEffect: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    for (type = 0; type < sizeof(effect_descs) / sizeof(effect_descs[0]);
+         type++)
+        if (strcmp(type_param.str_value.str, effect_descs[type].name) == 0)
+            break;
+    if (type == sizeof(effect_descs) / sizeof(effect_descs[0])) {
+        warning(ext_id,
+                _("Mix_Gawk_AddEffect: unknown effect `%s'"),
+                type_param.str_value.str);
+        RETURN_NOK;
+    }
+
+    if (chain->num_effects == MAX_EFFECTS) {
+        update_ERRNO_string(_("Mix_Gawk_AddEffect: too many effects"));
+        RETURN_NOK;
+    }
+
+    memset(&effect, 0, sizeof(effect));
+    effect.type = type;
+    for (i = 0; i < MAX_EFFECT_PARAMS; i++)
+        effect.params[i] = effect_descs[type].defaults[i];
+
+    /* a registered chain already knows the format it will process */
+    if (chain->freq > 0
+        && ! prepare_effect(&effect, chain->freq, chain->channels)) {
+        update_ERRNO_string(_("Mix_Gawk_AddEffect failed"));
+        RETURN_NOK;
+    }
+
+    SDL_LockMutex(chain->lock);
+    chain->effects[chain->num_effects] = effect;
+    i = chain->num_effects++;
+    SDL_UnlockMutex(chain->lock);
+
+    return make_number(i, result);
+}
+
+/* int Mix_Gawk_SetEffectParam(Mix_EffectChain *chain,
+                               int index,
+                               const char *name,
+                               double value); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_SetEffectParam --- provide a Mix_Gawk_SetEffectParam()
+                                  function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_SetEffectParam(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t chain_ptr_param;
+    awk_value_t index_param;
+    awk_value_t name_param;
+    awk_value_t value_param;
+    struct effect_chain *chain;
+    struct effect *effect;
+    const struct effect_desc *desc;
+    int index;
+    int i;
+
+    if (! get_argument(0, AWK_STRING, &chain_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &index_param)
+        || ! get_argument(2, AWK_STRING, &name_param)
+        || ! get_argument(3, AWK_NUMBER, &value_param)
+        || ! isfinite(value_param.num_value)
+        || (chain = find_effect_chain(chain_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_SetEffectParam: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    index = index_param.num_value;
+    if (index < 0 || index >= chain->num_effects) {
+        warning(ext_id, _("Mix_Gawk_SetEffectParam: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    effect = &chain->effects[index];
+    desc = &effect_descs[effect->type];
+    for (i = 0; i < MAX_EFFECT_PARAMS && desc->params[i] != NULL; i++)
+        if (strcmp(name_param.str_value.str, desc->params[i]) == 0)
+            break;
+    if (i == MAX_EFFECT_PARAMS || desc->params[i] == NULL) {
+        warning(ext_id,
+                _("Mix_Gawk_SetEffectParam: `%s' has no parameter `%s'"),
+                desc->name,
+                name_param.str_value.str);
+        RETURN_NOK;
+    }
+
+    SDL_LockMutex(chain->lock);
+    effect->params[i] = value_param.num_value;
+    if (chain->freq > 0)
+        update_effect(effect, chain->freq);
+    SDL_UnlockMutex(chain->lock);
+
+    RETURN_OK;
+}
+
+/* int Mix_Gawk_RegisterEffectChain(int channel, Mix_EffectChain *chain); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_RegisterEffectChain --- provide a
+                                       Mix_Gawk_RegisterEffectChain()
+                                       function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_RegisterEffectChain(int nargs,
+                                awk_value_t *result,
+                                struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t chain_ptr_param;
+    struct effect_chain *chain, *other;
+    int channel;
+    int freq;
+    uint16_t format;
+    int channels;
+    int i;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_STRING, &chain_ptr_param)
+        || (chain = find_effect_chain(chain_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_RegisterEffectChain: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+
+    /* the filter state belongs to one stream, and Mix_UnregisterEffect()
+       can only tell chains apart by channel */
+    for (other = effect_chains; other != NULL; other = other->next)
+        if (other->registered
+            && (other == chain || other->channel == channel)) {
+            update_ERRNO_string(
+                _("Mix_Gawk_RegisterEffectChain: already registered"));
+            return make_number(0, result);
+        }
+
+    if (! Mix_QuerySpec(&freq, &format, &channels)
+        || channels > MAX_EFFECT_CHANNELS) {
+        update_ERRNO_string(_("Mix_Gawk_RegisterEffectChain failed"));
+        return make_number(0, result);
+    }
+
+    if (freq != chain->freq || format != chain->format
+        || channels != chain->channels) {
+        for (i = 0; i < chain->num_effects; i++)
+            if (! prepare_effect(&chain->effects[i], freq, channels)) {
+                chain->freq = 0;
+                update_ERRNO_string(_("Mix_Gawk_RegisterEffectChain failed"));
+                return make_number(0, result);
+            }
+        chain->freq = freq;
+        chain->format = format;
+        chain->channels = channels;
+    }
+
+    chain->channel = channel;
+    chain->registered = awk_true;
+    ret = Mix_RegisterEffect(channel,
+                             effect_chain_callback,
+                             effect_chain_done,
+                             chain);
+    if (ret == 0) {
+        chain->registered = awk_false;
+        update_ERRNO_string(_("Mix_Gawk_RegisterEffectChain failed"));
+    }
+
+    return make_number(ret, result);
+}
+
+/* int Mix_Gawk_UnregisterEffectChain(int channel); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_UnregisterEffectChain --- provide a
+                                         Mix_Gawk_UnregisterEffectChain()
+                                         function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_UnregisterEffectChain(int nargs,
+                                  awk_value_t *result,
+                                  struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    int channel;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)) {
+        warning(ext_id,
+                _("Mix_Gawk_UnregisterEffectChain: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+
+    ret = Mix_UnregisterEffect(channel, effect_chain_callback);
+    if (ret == 0)
+        update_ERRNO_string(_("Mix_Gawk_UnregisterEffectChain failed"));
+
+    return make_number(ret, result);
+}
+
+/* void Mix_Gawk_FreeEffectChain(Mix_EffectChain *chain); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_FreeEffectChain --- provide a Mix_Gawk_FreeEffectChain()
+                                   function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_FreeEffectChain(int nargs,
+                            awk_value_t *result,
+                            struct awk_ext_func *finfo)
+{
+    awk_value_t chain_ptr_param;
+    struct effect_chain *chain, **link;
+    int i;
+
+    if (! get_argument(0, AWK_STRING, &chain_ptr_param)
+        || (chain = find_effect_chain(chain_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_FreeEffectChain: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* returns once the audio callback no longer uses the chain */
+    if (chain->registered)
+        Mix_UnregisterEffect(chain->channel, effect_chain_callback);
+
+    for (link = &effect_chains; *link != chain; link = &(*link)->next)
+        ;
+    *link = chain->next;
+
+    for (i = 0; i < chain->num_effects; i++) {
+        gawk_free(chain->effects[i].line);
+        gawk_free(chain->effects[i].reverb_buf);
+    }
+    SDL_DestroyMutex(chain->lock);
+    gawk_free(chain);
+
+    RETURN_OK;
+}
+
+enum attenuation_model {
+    ATTENUATION_LINEAR,
+    ATTENUATION_INVERSE,
+    ATTENUATION_EXPONENTIAL,
+};
+
+static struct {
+    enum attenuation_model model;
+    double ref_distance;      /* full volume up to this distance */
+    double max_distance;      /* no further attenuation beyond it */
+    double rolloff;
+} attenuation = { ATTENUATION_LINEAR, 1, 1000, 1 };
+
+/* attenuate --- return the gain in [0, 1] for a distance */
+
+static double
+attenuate(double distance)
+{
+    double ref = attenuation.ref_distance;
+    double max = attenuation.max_distance;
+    double gain;
+
+    distance = SDL_max(ref, SDL_min(distance, max));
+
+    switch (attenuation.model) {
+    case ATTENUATION_INVERSE:
+        gain = ref / (ref + attenuation.rolloff * (distance - ref));
+        break;
+    case ATTENUATION_EXPONENTIAL:
+        gain = pow(distance / ref, -attenuation.rolloff);
+        break;
+    case ATTENUATION_LINEAR:
+    default:
+        gain = max > ref ? 1 - attenuation.rolloff * (distance - ref)
+                                   / (max - ref)
+                         : 1;
+        break;
+    }
+
+    return SDL_max(0, SDL_min(gain, 1));
+}
+
+/* int Mix_Gawk_SetAttenuation(const char *model,
+                               double ref_distance,
+                               double max_distance,
+                               double rolloff); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_SetAttenuation --- provide a Mix_Gawk_SetAttenuation()
+                                  function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_SetAttenuation(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t model_param;
+    awk_value_t ref_distance_param;
+    awk_value_t max_distance_param;
+    awk_value_t rolloff_param;
+    const char *model;
+    int i;
+
+    if (! get_argument(0, AWK_STRING, &model_param)
+        || ! get_argument(1, AWK_NUMBER, &ref_distance_param)
+        || ! get_argument(2, AWK_NUMBER, &max_distance_param)
+        || ! get_argument(3, AWK_NUMBER, &rolloff_param)
+        || ref_distance_param.num_value <= 0
+        || max_distance_param.num_value < ref_distance_param.num_value
+        || rolloff_param.num_value < 0) {
+        warning(ext_id, _("Mix_Gawk_SetAttenuation: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    model = model_param.str_value.str;
+    if (strcmp(model, "linear") == 0)
+        attenuation.model = ATTENUATION_LINEAR;
+    else if (strcmp(model, "inverse") == 0)
+        attenuation.model = ATTENUATION_INVERSE;
+    else if (strcmp(model, "exponential") == 0)
+        attenuation.model = ATTENUATION_EXPONENTIAL;
+    else {
+        warning(ext_id,
+                _("Mix_Gawk_SetAttenuation: unknown model `%s'"),
+                model);
+        RETURN_NOK;
+    }
+
+    attenuation.ref_distance = ref_distance_param.num_value;
+    attenuation.max_distance = max_distance_param.num_value;
+    attenuation.rolloff = rolloff_param.num_value;
+
+    /* force the next listener update to touch every emitter */
+    for (i = 0; i < num_channel_states; i++)
+        channel_states[i].angle = -1;
+
+    RETURN_OK;
+}
+
+/* int Mix_Gawk_SetEmitter(int channel, double x, double y); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_SetEmitter --- provide a Mix_Gawk_SetEmitter()
+                              function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_SetEmitter(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    awk_value_t x_param, y_param;
+    struct channel_state *state;
+    int channel;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)
+        || ! get_argument(1, AWK_NUMBER, &x_param)
+        || ! get_argument(2, AWK_NUMBER, &y_param)
+        || channel_param.num_value < 0
+        || channel_param.num_value >= Mix_AllocateChannels(-1)) {
+        warning(ext_id, _("Mix_Gawk_SetEmitter: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+
+    if (! ensure_channel_states(channel + 1)) {
+        update_ERRNO_string(_("Mix_Gawk_SetEmitter failed"));
+        RETURN_NOK;
+    }
+
+    state = &channel_states[channel];
+    if (! state->emitter) {
+        state->emitter = awk_true;
+        state->angle = -1;
+    }
+    state->x = x_param.num_value;
+    state->y = y_param.num_value;
+
+    RETURN_OK;
+}
+
+/* int Mix_Gawk_ClearEmitter(int channel); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_ClearEmitter --- provide a Mix_Gawk_ClearEmitter()
+                                function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_ClearEmitter(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    awk_value_t channel_param;
+    int channel;
+
+    if (! get_argument(0, AWK_NUMBER, &channel_param)) {
+        warning(ext_id, _("Mix_Gawk_ClearEmitter: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+
+    if (channel >= 0 && channel < num_channel_states
+        && channel_states[channel].emitter) {
+        channel_states[channel].emitter = awk_false;
+        /* angle 0 at distance 0 unregisters the position effect */
+        if (channel_states[channel].angle >= 0)
+            Mix_SetPosition(channel, 0, 0);
+    }
+
+    RETURN_OK;
+}
+
+/* int Mix_Gawk_UpdateListener(double x, double y); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_UpdateListener --- provide a Mix_Gawk_UpdateListener()
+                                  function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_UpdateListener(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t x_param, y_param;
+    double x, y;
+    int updated;
+    int channel;
+
+    if (! get_argument(0, AWK_NUMBER, &x_param)
+        || ! get_argument(1, AWK_NUMBER, &y_param)) {
+        warning(ext_id, _("Mix_Gawk_UpdateListener: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    x = x_param.num_value;
+    y = y_param.num_value;
+
+    updated = 0;
+    for (channel = 0; channel < num_channel_states; channel++) {
+        struct channel_state *state = &channel_states[channel];
+        double dx, dy;
+        int angle, distance;
+        int generation;
+
+        if (! state->emitter)
+            continue;
+        if (! Mix_Playing(channel)) {
+            state->angle = -1;
+            continue;
+        }
+
+        /* 0 degrees is straight ahead (up on screen), 90 to the right */
+        dx = state->x - x;
+        dy = state->y - y;
+        angle = (int)lround(atan2(dx, -dy) * 180 / M_PI + 360) % 360;
+        distance = lround(255 * (1 - attenuate(sqrt(dx * dx + dy * dy))));
+
+        generation = channel_generation(channel);
+        if (angle == state->angle && distance == state->distance
+            && generation >= 0 && generation == state->generation)
+            continue;
+
+        if (Mix_SetPosition(channel, angle, distance) == 0) {
+            state->angle = -1;
+            continue;
+        }
+        state->pan = -1;
+        state->angle = angle;
+        state->distance = distance;
+        state->generation = generation;
+        updated++;
+    }
+
+    return make_number(updated, result);
+}
+
+/*----- Stream Samples from Gawk -------------------------------------------*/
+
+/* single-producer/single-consumer ring buffer: the script pushes samples
+   and the audio callback pulls them, so neither side ever blocks */
+struct audio_stream {
+    struct audio_stream *next;
+    uint8_t *buf;
+    uint32_t size;            /* power of two, in bytes */
+    SDL_atomic_t head;        /* written by the script only */
+    SDL_atomic_t tail;        /* written by the audio callback only */
+    uint16_t format;
+    int channels;
+    int frame_size;
+    uint32_t latency;         /* prefill target, in bytes */
+    awk_bool_t started;       /* audio thread only */
+    uint8_t silence[4];
+    SDL_atomic_t underruns;
+    SDL_atomic_t overruns;
+    Mix_Chunk *carrier;       /* silent looping chunk the stream replaces */
+    awk_bool_t registered;
+    int channel;
+};
+
+static struct audio_stream *audio_streams;
+
+#define MAX_STREAM_LATENCY 10000  /* ms */
+
+/* find_audio_stream --- look up an audio stream handle */
+
+static struct audio_stream *
+find_audio_stream(const char *handle)
+{
+    struct audio_stream *stream;
+    uintptr_t stream_ptr;
+
+    stream_ptr = strtoull(handle, (char **)NULL, 16);
+    for (stream = audio_streams; stream != NULL; stream = stream->next)
+        if ((uintptr_t)stream == stream_ptr)
+            return stream;
+
+    return NULL;
+}
+
+/* fill_silence --- fill a buffer with silence in the stream format */
+
+static void
+fill_silence(struct audio_stream *stream, uint8_t *dst, int len)
+{
+    int sample_size = stream->frame_size / stream->channels;
+    int i;
+
+    if (SDL_AUDIO_ISSIGNED(stream->format)) {
+        memset(dst, 0, len);
+        return;
+    }
+    for (i = 0; i + sample_size <= len; i += sample_size)
+        memcpy(dst + i, stream->silence, sample_size);
+}
+
+/* stream_write --- append bytes to the ring, return the number written */
+
+static uint32_t
+stream_write(struct audio_stream *stream, const uint8_t *src, uint32_t len)
+{
+    uint32_t head = SDL_AtomicGet(&stream->head);
+    uint32_t tail = SDL_AtomicGet(&stream->tail);
+    uint32_t space = stream->size - (head - tail);
+    uint32_t offset, first;
+
+    /* the ring size need not be a multiple of the frame size */
+    len = SDL_min(len, space);
+    len -= len % stream->frame_size;
+    offset = head & (stream->size - 1);
+    first = SDL_min(len, stream->size - offset);
+    memcpy(stream->buf + offset, src, first);
+    memcpy(stream->buf, src + first, len - first);
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&stream->head, head + len);
+    return len;
+}
+
+/* stream_callback --- feed the queued samples to the mixer */
+
+static void
+stream_callback(int chan, void *data, int len, void *udata)
+{
+    struct audio_stream *stream = udata;
+    uint32_t head = SDL_AtomicGet(&stream->head);
+    uint32_t tail = SDL_AtomicGet(&stream->tail);
+    uint32_t avail, offset, first, n;
+
+    SDL_MemoryBarrierAcquire();
+    avail = head - tail;
+
+    /* hold back until the latency target is queued, after each underrun */
+    if (! stream->started) {
+        if (avail < stream->latency) {
+            fill_silence(stream, data, len);
+            return;
+        }
+        stream->started = awk_true;
+    }
+
+    n = SDL_min(avail, (uint32_t)len);
+    n -= n % stream->frame_size;
+    offset = tail & (stream->size - 1);
+    first = SDL_min(n, stream->size - offset);
+    memcpy(data, stream->buf + offset, first);
+    memcpy((uint8_t *)data + first, stream->buf, n - first);
+    SDL_AtomicSet(&stream->tail, tail + n);
+
+    if (n < (uint32_t)len) {
+        fill_silence(stream, (uint8_t *)data + n, len - n);
+        SDL_AtomicAdd(&stream->underruns, 1);
+        stream->started = awk_false;
+    }
+}
+
+/* stream_done --- forget the channel once the carrier chunk stops */
+
+static void
+stream_done(int chan, void *udata)
+{
+    struct audio_stream *stream = udata;
+
+    stream->registered = awk_false;
+}
+
+/* Mix_Stream *Mix_Gawk_CreateStream(int latency_ms); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_CreateStream --- provide a Mix_Gawk_CreateStream()
+                                function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_CreateStream(int nargs,
+                         awk_value_t *result,
+                         struct awk_ext_func *finfo)
+{
+    struct audio_stream *stream;
+    awk_value_t latency_ms_param;
+    int latency_ms;
+    int freq;
+    uint16_t format;
+    int channels;
+    uint32_t size;
+    char stream_addr[20];
+
+    if (! get_argument(0, AWK_NUMBER, &latency_ms_param)
+        || latency_ms_param.num_value < 0
+        || latency_ms_param.num_value > MAX_STREAM_LATENCY) {
+        warning(ext_id, _("Mix_Gawk_CreateStream: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    latency_ms = latency_ms_param.num_value;
+
+    if (! Mix_QuerySpec(&freq, &format, &channels)
+        || (stream = gawk_calloc(1, sizeof(*stream))) == NULL) {
+        update_ERRNO_string(_("Mix_Gawk_CreateStream failed"));
+        return make_null_string(result);
+    }
+
+    stream->format = format;
+    stream->channels = channels;
+    stream->frame_size = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    stream->latency = (uint64_t)latency_ms * freq / 1000 * stream->frame_size;
+    write_sample(stream->silence, 0, format);
+
+    /* room for four times the latency target, and at least a second */
+    for (size = 4096; size < stream->latency * 4
+                      || size < (uint32_t)freq * stream->frame_size;
+         size <<= 1)
+        ;
+    stream->size = size;
+
+    stream->buf = gawk_malloc(size);
+    if (stream->buf == NULL) {
+        gawk_free(stream);
+        update_ERRNO_string(_("Mix_Gawk_CreateStream failed"));
+        return make_null_string(result);
+    }
+
+    stream->next = audio_streams;
+    audio_streams = stream;
+
+    // NOLINTNEXTLINE
+    snprintf(stream_addr, sizeof(stream_addr), "%p", stream);
+    return make_string_malloc(stream_addr, strlen(stream_addr), result);
+}
+
+/* int Mix_Gawk_PushStream(Mix_Stream *stream, awk_array_t *samples); */
+/* int Mix_Gawk_PushStream(Mix_Stream *stream, const char *data); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_PushStream --- provide a Mix_Gawk_PushStream()
+                              function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_PushStream(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t stream_ptr_param;
+    awk_value_t data_param;
+    struct audio_stream *stream;
+    uint32_t len, written;
+
+    if (! get_argument(0, AWK_STRING, &stream_ptr_param)
+        || ! get_argument(1, AWK_UNDEFINED, &data_param)
+        || (stream = find_audio_stream(stream_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_PushStream: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (data_param.val_type == AWK_ARRAY) {
+        /* samples in [-1.0, 1.0], interleaved, indexed from 1 */
+        int sample_size = stream->frame_size / stream->channels;
+        uint8_t block[4096];
+        uint32_t limit = sizeof(block) - sizeof(block) % stream->frame_size;
+        size_t count;
+        size_t i;
+
+        if (! get_element_count(data_param.array_cookie, &count)) {
+            warning(ext_id, _("Mix_Gawk_PushStream: bad parameter(s)"));
+            RETURN_NOK;
+        }
+        count -= count % stream->channels;
+
+        len = written = 0;
+        for (i = 0; i < count;) {
+            uint32_t n = 0;
+            uint32_t m;
+
+            for (; i < count && n + sample_size <= limit; i++) {
+                awk_value_t index, value;
+
+                if (! get_array_element(data_param.array_cookie,
+                                        make_number(i + 1, &index),
+                                        AWK_NUMBER,
+                                        &value))
+                    value.num_value = 0;
+                write_sample(block + n, value.num_value, stream->format);
+                n += sample_size;
+            }
+            len += n;
+            m = stream_write(stream, block, n);
+            written += m;
+            if (m < n) {
+                /* the ring is full, so the rest is dropped as well */
+                len += (count - i) * sample_size;
+                break;
+            }
+        }
+    } else if (data_param.val_type == AWK_STRING) {
+        /* raw bytes in the mixer format */
+        len = data_param.str_value.len;
+        len -= len % stream->frame_size;
+        written = stream_write(stream,
+                               (const uint8_t *)data_param.str_value.str,
+                               len);
+    } else {
+        warning(ext_id, _("Mix_Gawk_PushStream: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    if (written < len)
+        SDL_AtomicAdd(&stream->overruns, 1);
+
+    return make_number(written / stream->frame_size, result);
+}
+
+/* int Mix_Gawk_PlayStream(Mix_Stream *stream, int channel); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_PlayStream --- provide a Mix_Gawk_PlayStream()
+                              function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_PlayStream(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t stream_ptr_param;
+    awk_value_t channel_param;
+    struct audio_stream *stream;
+    int channel;
+    int ret;
+
+    if (! get_argument(0, AWK_STRING, &stream_ptr_param)
+        || ! get_argument(1, AWK_NUMBER, &channel_param)
+        || (stream = find_audio_stream(stream_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_PlayStream: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    channel = channel_param.num_value;
+
+    if (stream->registered) {
+        update_ERRNO_string(_("Mix_Gawk_PlayStream: already playing"));
+        RETURN_NOK;
+    }
+
+    /* the mixer only pulls from channels that play a chunk, so loop a
+       silent one and let the effect replace its contents */
+    if (stream->carrier == NULL) {
+        uint32_t len = 4096 * stream->frame_size;
+        uint8_t *abuf = SDL_malloc(len);
+
+        if (abuf == NULL
+            || (stream->carrier = Mix_QuickLoad_RAW(abuf, len)) == NULL) {
+            SDL_free(abuf);
+            update_ERRNO_string(_("Mix_Gawk_PlayStream failed"));
+            RETURN_NOK;
+        }
+        fill_silence(stream, abuf, len);
+        stream->carrier->allocated = 1;
+    }
+
+    ret = Mix_PlayChannel(channel, stream->carrier, -1);
+    if (ret < 0) {
+        update_ERRNO_string(_("Mix_Gawk_PlayStream failed"));
+        return make_number(ret, result);
+    }
+
+    stream->started = awk_false;
+    stream->channel = ret;
+    stream->registered = awk_true;
+    if (! Mix_RegisterEffect(ret, stream_callback, stream_done, stream)) {
+        stream->registered = awk_false;
+        Mix_HaltChannel(ret);
+        update_ERRNO_string(_("Mix_Gawk_PlayStream failed"));
+        RETURN_NOK;
+    }
+
+    return make_number(ret, result);
+}
+
+/* void Mix_Gawk_GetStreamStats(Mix_Stream *stream, awk_array_t *array); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_GetStreamStats --- provide a Mix_Gawk_GetStreamStats()
+                                  function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_GetStreamStats(int nargs,
+                           awk_value_t *result,
+                           struct awk_ext_func *finfo)
+{
+    awk_value_t stream_ptr_param;
+    awk_value_t array_param;
+    struct audio_stream *stream;
+    awk_array_t array;
+    awk_value_t index, value;
+    uint32_t queued;
+
+    if (! get_argument(0, AWK_STRING, &stream_ptr_param)
+        || ! get_argument(1, AWK_ARRAY, &array_param)
+        || (stream = find_audio_stream(stream_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_GetStreamStats: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    array = array_param.array_cookie;
+    queued = (uint32_t)SDL_AtomicGet(&stream->head)
+             - (uint32_t)SDL_AtomicGet(&stream->tail);
+
+    clear_array(array);
+    set_array_element(array,
+                      make_const_string("queued", 6, &index),
+                      make_number(queued / stream->frame_size, &value));
+    set_array_element(array,
+                      make_const_string("latency", 7, &index),
+                      make_number(stream->latency / stream->frame_size,
+                                  &value));
+    set_array_element(array,
+                      make_const_string("capacity", 8, &index),
+                      make_number(stream->size / stream->frame_size, &value));
+    set_array_element(array,
+                      make_const_string("underruns", 9, &index),
+                      make_number(SDL_AtomicGet(&stream->underruns), &value));
+    set_array_element(array,
+                      make_const_string("overruns", 8, &index),
+                      make_number(SDL_AtomicGet(&stream->overruns), &value));
+
+    RETURN_OK;
+}
+
+/* void Mix_Gawk_FreeStream(Mix_Stream *stream); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_FreeStream --- provide a Mix_Gawk_FreeStream()
+                              function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_FreeStream(int nargs,
+                       awk_value_t *result,
+                       struct awk_ext_func *finfo)
+{
+    awk_value_t stream_ptr_param;
+    struct audio_stream *stream, **link;
+
+    if (! get_argument(0, AWK_STRING, &stream_ptr_param)
+        || (stream = find_audio_stream(stream_ptr_param.str_value.str))
+               == NULL) {
+        warning(ext_id, _("Mix_Gawk_FreeStream: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    /* halting the channel also unregisters the effect */
+    if (stream->registered)
+        Mix_HaltChannel(stream->channel);
+    if (stream->carrier != NULL)
+        Mix_FreeChunk(stream->carrier);
+
+    for (link = &audio_streams; *link != stream; link = &(*link)->next)
+        ;
+    *link = stream->next;
+
+    gawk_free(stream->buf);
+    gawk_free(stream);
+
+    RETURN_OK;
+}
+
+/*----- Render Offline -----------------------------------------------------*/
+
+/* the "disk" driver, writing to /dev/null without delay, runs the audio
+   callback as fast as the mixer can go, and the postmix tap captures it;
+   the device stays paused between renders, so the mixer only advances
+   while a render is running */
+static struct offline_render {
+    int active;                   /* 0 unless opened offline */
+    SDL_AudioDeviceID device;     /* before SDL_mixer 2.8.0 only */
+    SDL_sem *done;
+    int freq;
+    uint16_t format;
+    int channels;
+    int frame_size;
+    uint8_t *buf;                 /* audio thread only while capturing */
+    uint32_t len;
+    uint32_t want;
+    uint8_t *carry;               /* rest of the last buffer mixed */
+    uint32_t carry_len;
+    uint32_t carry_size;
+    SDL_atomic_t capturing;
+    uint64_t frames;              /* last render, for Mix_Gawk_Stats() */
+    double seconds;
+    int was_running;              /* audio subsystem before opening */
+    char *saved_env[3];           /* NULL if unset */
+} offline;
+
+/* the environment switching SDL to the "disk" driver */
+static const char *const offline_env[3][2] = {
+    { "SDL_AUDIODRIVER", "disk" },
+    { "SDL_DISKAUDIOFILE", "/dev/null" },
+    { "SDL_DISKAUDIODELAY", "0" },
+};
+
+static void update_postmix(void);
+static void restore_audio(void);
+
+/* pause_offline --- pause or resume the device SDL_mixer opened */
+
+static void
+pause_offline(int pause_on)
+{
+    /* the lock is recursive, so this is safe inside the callback too */
+#if SDL_MIXER_VERSION_ATLEAST(2, 8, 0)
+    Mix_PauseAudio(pause_on);
+#else
+    SDL_PauseAudioDevice(offline.device, pause_on);
+#endif
+}
+
+/* capture_mix --- copy whole mixed buffers until the request is met */
+
+static void
+capture_mix(uint8_t *stream, int len)
+{
+    uint32_t n = SDL_min((uint32_t)len, offline.want - offline.len);
+
+    memcpy(offline.buf + offline.len, stream, n);
+    offline.len += n;
+    if (offline.len == offline.want) {
+        /* keep the rest for the next render, so renders join seamlessly */
+        offline.carry_len = SDL_min(len - n, offline.carry_size);
+        memcpy(offline.carry, stream + n, offline.carry_len);
+
+        /* no more buffers are mixed until the next render */
+        pause_offline(1);
+        SDL_AtomicSet(&offline.capturing, 0);
+        SDL_SemPost(offline.done);
+    }
+}
+
+/* start_disk_audio --- restart the audio subsystem on the "disk" driver,
+                        saving what restore_audio() needs to undo it */
+
+static awk_bool_t
+start_disk_audio(void)
+{
+    const char *value;
+    size_t i;
+
+    offline.was_running = SDL_WasInit(SDL_INIT_AUDIO) != 0;
+    if (offline.was_running) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+        /* initialized more than once, so it cannot be switched */
+        if (SDL_WasInit(SDL_INIT_AUDIO)) {
+            SDL_InitSubSystem(SDL_INIT_AUDIO);
+            return awk_false;
+        }
+    }
+
+    for (i = 0; i < SDL_arraysize(offline_env); i++) {
+        value = SDL_getenv(offline_env[i][0]);
+        offline.saved_env[i] = value != NULL ? SDL_strdup(value) : NULL;
+        SDL_setenv(offline_env[i][0], offline_env[i][1], 1);
+    }
+
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        restore_audio();
+        return awk_false;
+    }
+
+    return awk_true;
+}
+
+/* restore_audio --- undo start_disk_audio() */
+
+static void
+restore_audio(void)
+{
+    size_t i;
+
+    if (SDL_WasInit(SDL_INIT_AUDIO))
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    for (i = 0; i < SDL_arraysize(offline_env); i++) {
+        if (offline.saved_env[i] != NULL)
+            SDL_setenv(offline_env[i][0], offline.saved_env[i], 1);
+        else
+            unsetenv(offline_env[i][0]);
+        SDL_free(offline.saved_env[i]);
+        offline.saved_env[i] = NULL;
+    }
+
+    /* the same environment picks the same driver as before */
+    if (offline.was_running)
+        SDL_InitSubSystem(SDL_INIT_AUDIO);
+}
+
+/* end_offline --- leave offline mode once the audio is closed */
+
+static void
+end_offline(void)
+{
+    if (! offline.active)
+        return;
+
+    offline.active = 0;
+    offline.device = 0;
+    gawk_free(offline.carry);
+    offline.carry = NULL;
+    offline.carry_len = 0;
+    update_postmix();
+    restore_audio();
+}
+
+/* put_le --- store an unsigned value in little-endian order */
+
+static void
+put_le(uint8_t *dst, uint32_t value, int bytes)
+{
+    int i;
+
+    for (i = 0; i < bytes; i++)
+        dst[i] = (value >> (i * 8)) & 0xFF;
+}
+
+/* write_wav --- save captured audio as a RIFF WAVE file */
+
+static awk_bool_t
+write_wav(const char *path, const uint8_t *data, uint32_t len)
+{
+    uint8_t header[44];
+    int bits = SDL_AUDIO_BITSIZE(offline.format);
+    FILE *fp;
+    awk_bool_t ok;
+
+    /* WAVE stores little-endian samples, and unsigned only for 8 bits */
+    if ((bits > 8 && SDL_AUDIO_ISBIGENDIAN(offline.format))
+        || (bits > 8 && ! SDL_AUDIO_ISSIGNED(offline.format)))
+        return awk_false;
+
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, 36 + len, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);
+    put_le(header + 20, SDL_AUDIO_ISFLOAT(offline.format) ? 3 : 1, 2);
+    put_le(header + 22, offline.channels, 2);
+    put_le(header + 24, offline.freq, 4);
+    put_le(header + 28, offline.freq * offline.frame_size, 4);
+    put_le(header + 32, offline.frame_size, 2);
+    put_le(header + 34, bits, 2);
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, len, 4);
+
+    if ((fp = fopen(path, "wb")) == NULL)
+        return awk_false;
+    ok = fwrite(header, sizeof(header), 1, fp) == 1
+         && (len == 0 || fwrite(data, len, 1, fp) == 1);
+    if (fclose(fp) != 0)
+        ok = awk_false;
+
+    return ok;
+}
+
+/* int Mix_Gawk_OpenAudioOffline(int frequency,
+                                 Uint16 format,
+                                 int channels,
+                                 int chunksize); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_OpenAudioOffline --- provide a Mix_Gawk_OpenAudioOffline()
+                                    function for gawk */
+
+static awk_value_t *
+do_Mix_Gawk_OpenAudioOffline(int nargs,
+                             awk_value_t *result,
+                             struct awk_ext_func *finfo)
+{
+    awk_value_t frequency_param;
+    awk_value_t format_param;
+    awk_value_t channels_param;
+    awk_value_t chunksize_param;
+    int frequency;
+    uint16_t format;
+    int channels;
+    int chunksize;
+    int ret;
+
+    if (! get_argument(0, AWK_NUMBER, &frequency_param)
+        || ! get_argument(1, AWK_NUMBER, &format_param)
+        || ! get_argument(2, AWK_NUMBER, &channels_param)
+        || ! get_argument(3, AWK_NUMBER, &chunksize_param)) {
+        warning(ext_id, _("Mix_Gawk_OpenAudioOffline: bad parameter(s)"));
+        RETURN_NOK;
+    }
+
+    frequency = frequency_param.num_value;
+    format = format_param.num_value;
+    channels = channels_param.num_value;
+    chunksize = chunksize_param.num_value;
+
+    if (offline.done == NULL
+        && (offline.done = SDL_CreateSemaphore(0)) == NULL) {
+        update_ERRNO_string(_("Mix_Gawk_OpenAudioOffline failed"));
+        RETURN_NOK;
+    }
+
+    if (Mix_QuerySpec(NULL, NULL, NULL)) {
+        update_ERRNO_string(
+            _("Mix_Gawk_OpenAudioOffline: audio is already open"));
+        RETURN_NOK;
+    }
+
+    if (! start_disk_audio()) {
+        update_ERRNO_string(_("Mix_Gawk_OpenAudioOffline failed"));
+        RETURN_NOK;
+    }
+
+    ret = Mix_OpenAudio(frequency, format, channels, chunksize);
+    if (ret < 0) {
+        restore_audio();
+        update_ERRNO_string(_("Mix_Gawk_OpenAudioOffline failed"));
+        return make_number(ret, result);
+    }
+
+#if ! SDL_MIXER_VERSION_ATLEAST(2, 8, 0)
+    /* older SDL_mixer keeps its device id private, but the subsystem was
+       started just above, so the mixer's device is the only one open */
+    for (offline.device = 1; offline.device <= 16; offline.device++)
+        if (SDL_GetAudioDeviceStatus(offline.device) != SDL_AUDIO_STOPPED)
+            break;
+    if (offline.device > 16) {
+        Mix_CloseAudio();
+        restore_audio();
+        update_ERRNO_string(_("Mix_Gawk_OpenAudioOffline failed"));
+        RETURN_NOK;
+    }
+#endif
+
+    if (! Mix_QuerySpec(&offline.freq, &format, &channels)) {
+        Mix_CloseAudio();
+        restore_audio();
+        update_ERRNO_string(_("Mix_Gawk_OpenAudioOffline failed"));
+        RETURN_NOK;
+    }
+
+    pause_offline(1);
+    offline.format = format;
+    offline.channels = channels;
+    offline.frame_size = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+
+    /* SDL may round the buffer size up, so leave room for that */
+    gawk_free(offline.carry);
+    offline.carry_len = 0;
+    offline.carry_size = chunksize * 2 * offline.frame_size;
+    if ((offline.carry = gawk_malloc(offline.carry_size)) == NULL) {
+        Mix_CloseAudio();
+        restore_audio();
+        update_ERRNO_string(_("Mix_Gawk_OpenAudioOffline failed"));
+        RETURN_NOK;
+    }
 
-    ret = Mix_SetMusicPosition(position);
-    if (ret < 0)
-        update_ERRNO_string(_("Mix_SetMusicPosition failed"));
+    offline.active = 1;
+    update_postmix();
 
     return make_number(ret, result);
 }
 
-/* int Mix_SetMusicCMD(const char *command); */
-/* do_Mix_SetMusicCMD --- provide a Mix_SetMusicCMD() function for gawk */
+/* const char *Mix_Gawk_RenderOffline(int ms, const char *file); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_RenderOffline --- provide a Mix_Gawk_RenderOffline()
+                                 function for gawk */
 
 static awk_value_t *
-do_Mix_SetMusicCMD(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+do_Mix_Gawk_RenderOffline(int nargs,
+                          awk_value_t *result,
+                          struct awk_ext_func *finfo)
 {
-    awk_value_t command_param;
-    const char *command;
-    int ret;
-
-    if (! get_argument(0, AWK_STRING, &command_param)) {
-        warning(ext_id, _("Mix_SetMusicCMD: bad parameter(s)"));
+    awk_value_t ms_param;
+    awk_value_t file_param;
+    uint64_t frames;
+    uint64_t start;
+    uint64_t hash;
+    char digest[17];
+    uint32_t i;
+
+    if (! get_argument(0, AWK_NUMBER, &ms_param) || ms_param.num_value < 0) {
+        warning(ext_id, _("Mix_Gawk_RenderOffline: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    command = command_param.str_value.str;
-
-    ret = Mix_SetMusicCMD(command);
-    if (ret < 0)
-        update_ERRNO_string(_("Mix_SetMusicCMD failed"));
+    if (nargs > 1) {
+        if (! get_argument(1, AWK_STRING, &file_param)) {
+            warning(ext_id, _("Mix_Gawk_RenderOffline: bad parameter(s)"));
+            RETURN_NOK;
+        }
+    } else
+        file_param.str_value.str = NULL;
 
-    return make_number(ret, result);
-}
+    if (! offline.active) {
+        update_ERRNO_string(_("Mix_Gawk_RenderOffline: audio is not offline"));
+        return make_null_string(result);
+    }
 
-/* int Mix_HaltMusic(void); */
-/* do_Mix_HaltMusic --- provide a Mix_HaltMusic() function for gawk */
+    frames = (uint64_t)ms_param.num_value * offline.freq / 1000;
+    if (frames * offline.frame_size > UINT32_MAX
+        || (offline.buf = gawk_malloc(frames * offline.frame_size + 1))
+               == NULL) {
+        update_ERRNO_string(_("Mix_Gawk_RenderOffline failed"));
+        return make_null_string(result);
+    }
+    offline.want = frames * offline.frame_size;
+    offline.len = SDL_min(offline.carry_len, offline.want);
+    memcpy(offline.buf, offline.carry, offline.len);
+    offline.carry_len -= offline.len;
+    memmove(offline.carry, offline.carry + offline.len, offline.carry_len);
+
+    start = SDL_GetPerformanceCounter();
+    if (offline.len < offline.want) {
+        SDL_AtomicSet(&offline.capturing, 1);
+        pause_offline(0);
+        SDL_SemWait(offline.done);
+    }
+    offline.frames = frames;
+    offline.seconds = (double)(SDL_GetPerformanceCounter() - start)
+                      / SDL_GetPerformanceFrequency();
+
+    /* FNV-1a, enough to tell renders apart in regression tests */
+    hash = 0xcbf29ce484222325ULL;
+    for (i = 0; i < offline.len; i++) {
+        hash ^= offline.buf[i];
+        hash *= 0x100000001b3ULL;
+    }
 
-static awk_value_t *
-do_Mix_HaltMusic(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
-{
-    return make_number(Mix_HaltMusic(), result);
-}
+    if (file_param.str_value.str != NULL
+        && ! write_wav(file_param.str_value.str, offline.buf, offline.len)) {
+        gawk_free(offline.buf);
+        offline.buf = NULL;
+        update_ERRNO_string(_("Mix_Gawk_RenderOffline: cannot write file"));
+        return make_null_string(result);
+    }
 
-/* int Mix_PlayingMusic(void); */
-/* do_Mix_PlayingMusic --- provide a Mix_PlayingMusic() function for gawk */
+    gawk_free(offline.buf);
+    offline.buf = NULL;
 
-static awk_value_t *
-do_Mix_PlayingMusic(int nargs,
-                    awk_value_t *result,
-                    struct awk_ext_func *finfo)
-{
-    return make_number(Mix_PlayingMusic(), result);
+    snprintf(digest, sizeof(digest), "%016" PRIx64, hash);
+    return make_string_malloc(digest, strlen(digest), result);
 }
 
-/*----- Handle Effects -----------------------------------------------------*/
+/*----- Measure the Mixer --------------------------------------------------*/
 
-/* int Mix_SetPanning(int channel, Uint8 left, Uint8 right); */
-/* do_Mix_SetPanning --- provide a Mix_SetPanning() function for gawk */
+/* measure_mix --- gather statistics after each mixed buffer */
 
-static awk_value_t *
-do_Mix_SetPanning(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+static void
+measure_mix(uint8_t *stream, int len)
 {
-    awk_value_t channel_param;
-    awk_value_t left_param, right_param;
+    struct mixer_stats *st = &mixer_stats;
+    uint64_t now = SDL_GetPerformanceCounter();
+    double period;
+    int numchans;
     int channel;
-    uint8_t left, right;
-    int ret;
 
-    if (! get_argument(0, AWK_NUMBER, &channel_param)
-        || ! get_argument(1, AWK_NUMBER, &left_param)
-        || ! get_argument(2, AWK_NUMBER, &right_param)) {
-        warning(ext_id, _("Mix_SetPanning: bad parameter(s)"));
-        RETURN_NOK;
+    period = (double)len / st->frame_size / st->freq;
+
+    /* a gap well beyond one period means the device was starved */
+    if (st->last_counter != 0) {
+        double interval = (double)(now - st->last_counter)
+                          / SDL_GetPerformanceFrequency();
+
+        st->interval_sum += interval;
+        st->interval_max = SDL_max(st->interval_max, interval);
+        if (interval > period * 1.5)
+            st->late++;
     }
+    st->last_counter = now;
 
-    channel = channel_param.num_value;
-    left = left_param.num_value;
-    right = right_param.num_value;
+    st->dsp_sum += st->dsp_current;
+    st->dsp_max = SDL_max(st->dsp_max, st->dsp_current);
+    st->dsp_current = 0;
 
-    ret = Mix_SetPanning(channel, left, right);
-    if (ret == 0)
-        update_ERRNO_string(_("Mix_SetPanning failed"));
+    numchans = SDL_min(Mix_AllocateChannels(-1), MAX_TRACKED_CHANNELS);
+    for (channel = 0; channel < numchans; channel++)
+        if (Mix_Playing(channel)) {
+            st->active[channel]++;
+            st->active_sum++;
+        }
 
-    return make_number(ret, result);
+    st->callbacks++;
+    st->frames += len / st->frame_size;
 }
 
-/* int Mix_SetDistance(int channel, Uint8 distance); */
-/* do_Mix_SetDistance --- provide a Mix_SetDistance() function for gawk */
+/* postmix_callback --- run the postmix hooks that are in use */
 
-static awk_value_t *
-do_Mix_SetDistance(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+static void
+postmix_callback(void *udata, uint8_t *stream, int len)
 {
-    awk_value_t channel_param;
-    awk_value_t distance_param;
-    int channel;
-    uint8_t distance;
-    int ret;
-
-    if (! get_argument(0, AWK_NUMBER, &channel_param)
-        || ! get_argument(1, AWK_NUMBER, &distance_param)) {
-        warning(ext_id, _("Mix_SetDistance: bad parameter(s)"));
-        RETURN_NOK;
-    }
-
-    channel = channel_param.num_value;
-    distance = distance_param.num_value;
+    if (mixer_stats.enabled)
+        measure_mix(stream, len);
+    if (SDL_AtomicGet(&offline.capturing))
+        capture_mix(stream, len);
+}
 
-    ret = Mix_SetDistance(channel, distance);
-    if (ret == 0)
-        update_ERRNO_string(_("Mix_SetDistance failed"));
+/* update_postmix --- install the postmix callback only while needed */
 
-    return make_number(ret, result);
+static void
+update_postmix(void)
+{
+    /* Mix_SetPostMix() waits for the audio callback to finish */
+    if (mixer_stats.enabled || offline.active)
+        Mix_SetPostMix(postmix_callback, NULL);
+    else
+        Mix_SetPostMix(NULL, NULL);
 }
 
-/* int Mix_SetPosition(int channel, Sint16 angle, Uint8 distance); */
-/* do_Mix_SetPosition --- provide a Mix_SetPosition() function for gawk */
+/* int Mix_Gawk_EnableStats(int enable); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_EnableStats --- provide a Mix_Gawk_EnableStats()
+                               function for gawk */
 
 static awk_value_t *
-do_Mix_SetPosition(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
+do_Mix_Gawk_EnableStats(int nargs,
+                        awk_value_t *result,
+                        struct awk_ext_func *finfo)
 {
-    awk_value_t channel_param;
-    awk_value_t angle_param;
-    awk_value_t distance_param;
-    int channel;
-    int16_t angle;
-    uint8_t distance;
-    int ret;
+    awk_value_t enable_param;
+    int freq;
+    uint16_t format;
+    int channels;
 
-    if (! get_argument(0, AWK_NUMBER, &channel_param)
-        || ! get_argument(1, AWK_NUMBER, &angle_param)
-        || ! get_argument(2, AWK_NUMBER, &distance_param)) {
-        warning(ext_id, _("Mix_SetPosition: bad parameter(s)"));
+    if (! get_argument(0, AWK_NUMBER, &enable_param)) {
+        warning(ext_id, _("Mix_Gawk_EnableStats: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    channel = channel_param.num_value;
-    angle = angle_param.num_value;
-    distance = distance_param.num_value;
+    if (enable_param.num_value == 0) {
+        mixer_stats.enabled = awk_false;
+        update_postmix();
+        RETURN_OK;
+    }
 
-    ret = Mix_SetPosition(channel, angle, distance);
-    if (ret == 0)
-        update_ERRNO_string(_("Mix_SetPosition failed"));
+    if (! Mix_QuerySpec(&freq, &format, &channels)) {
+        update_ERRNO_string(_("Mix_Gawk_EnableStats failed"));
+        RETURN_NOK;
+    }
 
-    return make_number(ret, result);
+    /* stop measuring first, so the reset below cannot race the audio
+       callback */
+    mixer_stats.enabled = awk_false;
+    update_postmix();
+    memset(&mixer_stats, 0, offsetof(struct mixer_stats, voices_played));
+    mixer_stats.freq = freq;
+    mixer_stats.frame_size = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    mixer_stats.enabled = awk_true;
+    update_postmix();
+
+    RETURN_OK;
 }
 
-/* int Mix_SetReverseStereo(int channel, int flip); */
-/* do_Mix_SetReverseStereo --- provide a Mix_SetReverseStereo()
-                               function for gawk */
+/* set_stat --- store one statistic in an awk array */
+
+static void
+set_stat(awk_array_t array, const char *name, double num)
+{
+    awk_value_t index, value;
+
+    set_array_element(array,
+                      make_const_string(name, strlen(name), &index),
+                      make_number(num, &value));
+}
+
+/* void Mix_Gawk_Stats(awk_array_t *array); */
+// /* It doesn't exist in SDL2_mixer */
+/* do_Mix_Gawk_Stats --- provide a Mix_Gawk_Stats() function for gawk */
 
 static awk_value_t *
-do_Mix_SetReverseStereo(int nargs,
-                        awk_value_t *result,
-                        struct awk_ext_func *finfo)
+do_Mix_Gawk_Stats(int nargs, awk_value_t *result, struct awk_ext_func *finfo)
 {
-    awk_value_t channel_param;
-    awk_value_t flip_param;
+    awk_value_t array_param;
+    awk_array_t array;
+    struct mixer_stats st;
+    awk_value_t subsep;
+    struct audio_stream *stream;
+    uint64_t underruns, overruns;
+    double period;
+    int numchans;
     int channel;
-    int flip;
-    int ret;
 
-    if (! get_argument(0, AWK_NUMBER, &channel_param)
-        || ! get_argument(1, AWK_NUMBER, &flip_param)) {
-        warning(ext_id, _("Mix_SetReverseStereo: bad parameter(s)"));
+    if (! get_argument(0, AWK_ARRAY, &array_param)) {
+        warning(ext_id, _("Mix_Gawk_Stats: bad parameter(s)"));
         RETURN_NOK;
     }
 
-    channel = channel_param.num_value;
-    flip = flip_param.num_value;
+    array = array_param.array_cookie;
 
-    ret = Mix_SetReverseStereo(channel, flip);
-    if (ret == 0)
-        update_ERRNO_string(_("Mix_SetReverseStereo failed"));
+    /* a snapshot, the audio thread keeps counting meanwhile */
+    st = mixer_stats;
 
-    return make_number(ret, result);
+    clear_array(array);
+    set_stat(array, "enabled", st.enabled);
+    set_stat(array, "callbacks", st.callbacks);
+    if (st.callbacks > 0) {
+        period = (double)st.frames / st.callbacks / st.freq;
+        set_stat(array, "period_ms", period * 1000);
+        set_stat(array, "dsp_avg_ms", st.dsp_sum / st.callbacks * 1000);
+        set_stat(array, "dsp_max_ms", st.dsp_max * 1000);
+        set_stat(array, "load", st.dsp_sum / st.callbacks / period);
+        set_stat(array, "active_avg", (double)st.active_sum / st.callbacks);
+    }
+    if (st.callbacks > 1) {
+        set_stat(array,
+                 "interval_avg_ms",
+                 st.interval_sum / (st.callbacks - 1) * 1000);
+        set_stat(array, "interval_max_ms", st.interval_max * 1000);
+    }
+    set_stat(array, "late", st.late);
+
+    /* per-channel activity as array["active", channel], joined with
+       whatever SUBSEP the script uses */
+    if (sym_lookup("SUBSEP", AWK_STRING, &subsep)) {
+        numchans = SDL_min(Mix_AllocateChannels(-1), MAX_TRACKED_CHANNELS);
+        for (channel = 0; channel < numchans; channel++) {
+            char name[64];
+
+            snprintf(name,
+                     sizeof(name),
+                     "active%.*s%d",
+                     (int)SDL_min(subsep.str_value.len, 32),
+                     subsep.str_value.str,
+                     channel);
+            set_stat(array, name, st.active[channel]);
+        }
+    }
+
+    set_stat(array, "voices_played", st.voices_played);
+    set_stat(array, "voices_stolen", st.voices_stolen);
+    set_stat(array, "voices_dropped", st.voices_dropped);
+
+    underruns = overruns = 0;
+    for (stream = audio_streams; stream != NULL; stream = stream->next) {
+        underruns += SDL_AtomicGet(&stream->underruns);
+        overruns += SDL_AtomicGet(&stream->overruns);
+    }
+    set_stat(array, "stream_underruns", underruns);
+    set_stat(array, "stream_overruns", overruns);
+
+    if (offline.frames > 0) {
+        set_stat(array, "render_frames", offline.frames);
+        set_stat(array, "render_ms", offline.seconds * 1000);
+        set_stat(array,
+                 "render_speed",
+                 offline.frames / (offline.seconds * offline.freq));
+    }
+
+    RETURN_OK;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -716,6 +4010,10 @@ static awk_ext_func_t func_table[] = {
     { "Mix_GetError", do_Mix_GetError, 0, 0, awk_false, NULL },
     { "Mix_LoadWAV", do_Mix_LoadWAV, 1, 1, awk_false, NULL },
     { "Mix_FreeChunk", do_Mix_FreeChunk, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_Synthesize", do_Mix_Gawk_Synthesize,
+      1, 1,
+      awk_false,
+      NULL },
     { "Mix_AllocateChannels", do_Mix_AllocateChannels,
       1, 1,
       awk_false,
@@ -725,8 +4023,43 @@ static awk_ext_func_t func_table[] = {
       4, 4,
       awk_false,
       NULL },
+    { "Mix_FadeInChannel", do_Mix_FadeInChannelTimed,
+      4, 4,
+      awk_false,
+      NULL },
+    { "Mix_FadeInChannelTimed", do_Mix_FadeInChannelTimed,
+      5, 5,
+      awk_false,
+      NULL },
     { "Mix_HaltChannel", do_Mix_HaltChannel, 1, 1, awk_false, NULL },
+    { "Mix_Volume", do_Mix_Volume, 2, 2, awk_false, NULL },
+    { "Mix_ExpireChannel", do_Mix_ExpireChannel, 2, 2, awk_false, NULL },
+    { "Mix_FadeOutChannel", do_Mix_FadeOutChannel,
+      2, 2,
+      awk_false,
+      NULL },
     { "Mix_Playing", do_Mix_Playing, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_PlayVoice", do_Mix_Gawk_PlayVoice,
+      4, 2,
+      awk_false,
+      NULL },
+    { "Mix_ReserveChannels", do_Mix_ReserveChannels,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_GroupChannel", do_Mix_GroupChannel, 2, 2, awk_false, NULL },
+    { "Mix_GroupChannels", do_Mix_GroupChannels, 3, 3, awk_false, NULL },
+    { "Mix_GroupCount", do_Mix_GroupCount, 1, 1, awk_false, NULL },
+    { "Mix_FadeOutGroup", do_Mix_FadeOutGroup, 2, 2, awk_false, NULL },
+    { "Mix_HaltGroup", do_Mix_HaltGroup, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_GroupVolume", do_Mix_Gawk_GroupVolume,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_GroupPanning", do_Mix_Gawk_GroupPanning,
+      3, 3,
+      awk_false,
+      NULL },
     { "Mix_LoadMUS", do_Mix_LoadMUS, 1, 1, awk_false, NULL },
     { "Mix_FreeMusic", do_Mix_FreeMusic, 1, 1, awk_false, NULL },
     { "Mix_PlayMusic", do_Mix_PlayMusic, 2, 2, awk_false, NULL },
@@ -738,6 +4071,22 @@ static awk_ext_func_t func_table[] = {
     { "Mix_SetMusicCMD", do_Mix_SetMusicCMD, 1, 1, awk_false, NULL },
     { "Mix_HaltMusic", do_Mix_HaltMusic, 0, 0, awk_false, NULL },
     { "Mix_PlayingMusic", do_Mix_PlayingMusic, 0, 0, awk_false, NULL },
+    { "Mix_FadeInMusic", do_Mix_FadeInMusic, 3, 3, awk_false, NULL },
+    { "Mix_FadeOutMusic", do_Mix_FadeOutMusic, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_LoadMUSAsync", do_Mix_Gawk_LoadMUSAsync,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_PlayMUSWhenReady", do_Mix_Gawk_PlayMUSWhenReady,
+      3, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_PollMUS", do_Mix_Gawk_PollMUS, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_GetMUS", do_Mix_Gawk_GetMUS, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_FreeMUSAsync", do_Mix_Gawk_FreeMUSAsync,
+      1, 1,
+      awk_false,
+      NULL },
     { "Mix_SetPanning", do_Mix_SetPanning, 3, 3, awk_false, NULL },
     { "Mix_SetDistance", do_Mix_SetDistance, 2, 2, awk_false, NULL },
     { "Mix_SetPosition", do_Mix_SetPosition, 3, 3, awk_false, NULL },
@@ -745,6 +4094,79 @@ static awk_ext_func_t func_table[] = {
       2, 2,
       awk_false,
       NULL },
+    { "Mix_Gawk_CreateEffectChain", do_Mix_Gawk_CreateEffectChain,
+      0, 0,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_AddEffect", do_Mix_Gawk_AddEffect,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_SetEffectParam", do_Mix_Gawk_SetEffectParam,
+      4, 4,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_RegisterEffectChain", do_Mix_Gawk_RegisterEffectChain,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_UnregisterEffectChain", do_Mix_Gawk_UnregisterEffectChain,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_FreeEffectChain", do_Mix_Gawk_FreeEffectChain,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_SetAttenuation", do_Mix_Gawk_SetAttenuation,
+      4, 4,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_SetEmitter", do_Mix_Gawk_SetEmitter,
+      3, 3,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_ClearEmitter", do_Mix_Gawk_ClearEmitter,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_UpdateListener", do_Mix_Gawk_UpdateListener,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_CreateStream", do_Mix_Gawk_CreateStream,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_PushStream", do_Mix_Gawk_PushStream,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_PlayStream", do_Mix_Gawk_PlayStream,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_GetStreamStats", do_Mix_Gawk_GetStreamStats,
+      2, 2,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_FreeStream", do_Mix_Gawk_FreeStream,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_EnableStats", do_Mix_Gawk_EnableStats,
+      1, 1,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_Stats", do_Mix_Gawk_Stats, 1, 1, awk_false, NULL },
+    { "Mix_Gawk_OpenAudioOffline", do_Mix_Gawk_OpenAudioOffline,
+      4, 4,
+      awk_false,
+      NULL },
+    { "Mix_Gawk_RenderOffline", do_Mix_Gawk_RenderOffline,
+      2, 1,
+      awk_false,
+      NULL },
 };
 
 /* define the dl_load() function using the boilerplate macro */